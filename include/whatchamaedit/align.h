@@ -0,0 +1,219 @@
+/* ROM alignment
+ *
+ * Maps addresses in one ROM to addresses in another, e.g. from one release of
+ * a game to another, or from a game to a hack built from it, by finding the
+ * parts the two have in common.
+ *
+ * Every non-overlapping 32 byte block of the second ROM is hashed, and a
+ * Rabin-Karp rolling hash of every 32 byte window of the first ROM is looked
+ * up in those. Windows that match a block that only occurs once are anchors;
+ * the longest chain of anchors that is in order in both ROMs is kept, so the
+ * map is monotone, and each anchor is then extended byte by byte in both
+ * directions for as long as the two ROMs agree.
+ */
+
+#if !defined(WHATCHAMAEDIT_ALIGN_H)
+#define WHATCHAMAEDIT_ALIGN_H
+
+#include <whatchamaedit/view.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class alignment {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  /* a run of bytes that are the same in both ROMs. */
+  struct segment {
+    std::size_t a;
+    std::size_t b;
+    std::size_t length;
+  };
+
+  /** @constructor
+   *
+   * @a the ROM to map addresses from.
+   * @b the ROM to map addresses to.
+   * @window the size of the blocks that are hashed; larger windows make for
+   * fewer spurious anchors, smaller ones find shorter common runs.
+   */
+  alignment(const view &a, const view &b, const std::size_t window = 32)
+      : a_{a.raw()}, b_{b.raw()}, window_{window} {
+    if (window_ == 0 || a_.size() < window_ || b_.size() < window_) {
+      return;
+    }
+
+    extend(chain(anchors()));
+  }
+
+  /* where @p in the first ROM ended up in the second one, if anywhere. */
+  std::optional<pointer> translate(const pointer p) const {
+    const std::size_t l = p.linear();
+    auto it = std::upper_bound(
+        segments_.begin(), segments_.end(), l,
+        [](const std::size_t v, const segment &s) { return v < s.a; });
+
+    if (it == segments_.begin()) {
+      return {};
+    }
+
+    it--;
+
+    if (l >= it->a + it->length) {
+      return {};
+    }
+
+    return pointer{it->b + (l - it->a)};
+  }
+
+  const std::vector<segment> &segments(void) const { return segments_; }
+
+  /* the share of the first ROM that could be mapped. */
+  double coverage(void) const {
+    std::size_t n = 0;
+
+    for (const auto &s : segments_) {
+      n += s.length;
+    }
+
+    return a_.empty() ? 0 : double(n) / a_.size();
+  }
+
+ protected:
+  const std::basic_string_view<B> a_;
+  const std::basic_string_view<B> b_;
+  const std::size_t window_;
+  std::vector<segment> segments_{};
+
+  static constexpr uint64_t prime = 0x100000001b3;
+
+  uint64_t hash(const B *d) const {
+    uint64_t h = 0;
+
+    for (std::size_t i = 0; i < window_; i++) {
+      h = h * prime + uint8_t(d[i]);
+    }
+
+    return h;
+  }
+
+  /* runs of a single byte value are everywhere and never make good anchors. */
+  bool uniform(const B *d) const {
+    return std::all_of(d, d + window_, [d](const B v) { return v == d[0]; });
+  }
+
+  /* all (a, b) pairs of matching windows, ordered by a. */
+  std::vector<std::pair<std::size_t, std::size_t>> anchors(void) const {
+    constexpr std::size_t ambiguous = ~std::size_t(0);
+    std::unordered_map<uint64_t, std::size_t> blocks{};
+    blocks.reserve(b_.size() / window_);
+
+    for (std::size_t i = 0; i + window_ <= b_.size(); i += window_) {
+      if (uniform(b_.data() + i)) {
+        continue;
+      }
+
+      const auto [it, added] = blocks.emplace(hash(b_.data() + i), i);
+      if (!added) {
+        it->second = ambiguous;
+      }
+    }
+
+    uint64_t top = 1;
+    for (std::size_t i = 1; i < window_; i++) {
+      top *= prime;
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> rv{};
+    uint64_t h = hash(a_.data());
+
+    for (std::size_t i = 0;; i++) {
+      const auto it = blocks.find(h);
+
+      if (it != blocks.end() && it->second != ambiguous &&
+          a_.compare(i, window_, b_.substr(it->second, window_)) == 0) {
+        rv.push_back({i, it->second});
+      }
+
+      if (i + window_ >= a_.size()) {
+        break;
+      }
+
+      h = (h - uint8_t(a_[i]) * top) * prime + uint8_t(a_[i + window_]);
+    }
+
+    return rv;
+  }
+
+  /* the longest chain of anchors that is increasing in both ROMs. */
+  static std::vector<std::pair<std::size_t, std::size_t>> chain(
+      const std::vector<std::pair<std::size_t, std::size_t>> &anchors) {
+    std::vector<std::size_t> tails{}, previous(anchors.size());
+
+    for (std::size_t i = 0; i < anchors.size(); i++) {
+      const auto it = std::lower_bound(
+          tails.begin(), tails.end(), anchors[i].second,
+          [&anchors](const std::size_t t, const std::size_t b) {
+            return anchors[t].second < b;
+          });
+
+      previous[i] = it == tails.begin() ? ~std::size_t(0) : *(it - 1);
+
+      if (it == tails.end()) {
+        tails.push_back(i);
+      } else {
+        *it = i;
+      }
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> rv(tails.size());
+    std::size_t i = tails.empty() ? 0 : tails.back();
+
+    for (auto r = rv.rbegin(); r != rv.rend(); r++, i = previous[i]) {
+      *r = anchors[i];
+    }
+
+    return rv;
+  }
+
+  /* grow anchors into segments, without letting segments overlap. */
+  void extend(const std::vector<std::pair<std::size_t, std::size_t>> &chain) {
+    for (const auto &[a, b] : chain) {
+      std::size_t start = 0, end = window_;
+      const std::size_t floorA =
+          segments_.empty() ? 0 : segments_.back().a + segments_.back().length;
+      const std::size_t floorB =
+          segments_.empty() ? 0 : segments_.back().b + segments_.back().length;
+
+      /* this also skips anchors that the previous segment already covers. */
+      if (a < floorA || b < floorB) {
+        continue;
+      }
+
+      while (a - start > floorA && b - start > floorB &&
+             a_[a - start - 1] == b_[b - start - 1]) {
+        start++;
+      }
+
+      while (a + end < a_.size() && b + end < b_.size() &&
+             a_[a + end] == b_[b + end]) {
+        end++;
+      }
+
+      segments_.push_back({a - start, b - start, start + end});
+    }
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,346 @@
+/* Batch text edits
+ *
+ * Applies any number of text edits to a ROM as a single transaction: every
+ * edit is encoded and checked against the space available at its target
+ * before anything is written, and if any one of them doesn't fit then nothing
+ * is written at all.
+ *
+ * The file format is line based:
+ *
+ *     # comments start with a hash
+ *     @intro 1a:4f20
+ *     0x0e4d2a	Hello there!
+ *     1c:5b00	{player} got a POKé BALL!
+ *     intro	Welcome to the world of POKéMON!
+ *
+ * Lines starting with '@' define a label for an address. All other lines are
+ * edits: a target, i.e. an address or a label, followed by whitespace and the
+ * new text, which may use any glyph or control code in the charmap.
+ */
+
+#if !defined(WHATCHAMAEDIT_BATCH_H)
+#define WHATCHAMAEDIT_BATCH_H
+
+#include <whatchamaedit/character-map.h>
+#include <whatchamaedit/view.h>
+
+#include <algorithm>
+#include <atomic>
+#include <istream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class batch {
+ public:
+  using pointer = gameboy::rom::pointer<K, W>;
+  using view = gameboy::rom::view<B, W, K>;
+  using bytes = std::basic_string<B>;
+
+  struct edit {
+    std::size_t line;
+    std::string target;
+    std::string text;
+  };
+
+  struct error {
+    std::size_t line;
+    std::string message;
+  };
+
+  /* read edits and labels from a batch file.
+   *
+   * Can be called multiple times to combine several files into a single batch.
+   * Returns false if there were syntax errors, which are also added to
+   * errors() and stay there; lines with errors are left out of the batch.
+   */
+  bool load(std::istream &in) {
+    bool ok = true;
+    std::string l;
+
+    while (std::getline(in, l)) {
+      line_++;
+
+      if (!l.empty() && l.back() == '\r') {
+        l.pop_back();
+      }
+
+      const auto start = l.find_first_not_of(" \t");
+      if (start == std::string::npos || l[start] == '#') {
+        continue;
+      }
+
+      const auto sep = l.find_first_of(" \t", start);
+      const auto text = l.find_first_not_of(" \t", sep);
+      const std::string target = l.substr(start, sep - start);
+
+      if (target.front() == '@') {
+        if (target.size() < 2 || text == std::string::npos) {
+          syntax_.push_back({line_, "malformed label definition"});
+          ok = false;
+          continue;
+        }
+
+        const auto p = pointer::parse(l.substr(text));
+        if (!p) {
+          syntax_.push_back(
+              {line_, "label '" + target.substr(1) + "' has no valid address"});
+          ok = false;
+        } else if (!labels_.emplace(target.substr(1), *p).second) {
+          syntax_.push_back(
+              {line_, "label '" + target.substr(1) + "' defined twice"});
+          ok = false;
+        }
+
+        continue;
+      }
+
+      add(target, text == std::string::npos ? "" : l.substr(text));
+    }
+
+    errors_ = syntax_;
+
+    return ok;
+  }
+
+  /* add a single edit.
+   *
+   * @target an address in any format pointer::parse() understands, or the
+   * name of a label.
+   * @text the new text, without a terminator.
+   */
+  void add(const std::string &target, const std::string &text) {
+    add(target, text, line_);
+  }
+
+  /* like the other add(), but for an edit that came from @line of some other
+   * file, e.g. a translation file, so errors point there instead. */
+  void add(const std::string &target, const std::string &text,
+           const std::size_t line) {
+    edits_.push_back({line, target, text});
+  }
+
+  /* apply all edits to a ROM.
+   *
+   * @rom the ROM to edit; needs to provide write(), fixHeaderChecksum(),
+   * fixChecksum() and language() like whatchamaedit::rom::gb does.
+   *
+   * Text is encoded with the charmap of the ROM's language. The available
+   * space for each edit is the existing string at its target,
+   * including its terminator. New text that is shorter than that is padded
+   * with terminators. Edits are validated as a whole first, and all problems
+   * are reported in errors(), replacing whatever an earlier apply() found;
+   * only if there are none are the edits written, in a single pass ordered by
+   * address, after which both checksums are fixed once. The whole batch forms
+   * a single group in the ROM's undo history.
+   * Edits that would write the bytes that are already there are skipped, and
+   * if that's all of them, the ROM isn't touched at all.
+   *
+   * @threads the number of threads to encode and check edits with; 0 means
+   * one per hardware thread. Only the writing itself is done in one go at the
+   * end, on the calling thread.
+   */
+  template <typename R>
+  bool apply(R &rom, std::size_t threads = 0) {
+    struct planned {
+      pointer target{std::size_t(0)};
+      bytes data;
+      std::size_t line;
+      /* whether the ROM already has these bytes. */
+      bool same;
+    };
+
+    errors_ = syntax_;
+    applied_ = 0;
+
+    const std::size_t syntax = errors_.size();
+    const text::language &language = rom.language();
+    const text::encoder encoder{language.map()};
+    const view v{rom};
+    std::vector<planned> plan(edits_.size());
+    std::vector<std::string> problems(edits_.size());
+
+    const auto check = [&](const std::size_t i) {
+      const auto &e = edits_[i];
+      std::optional<pointer> target = pointer::parse(e.target);
+
+      if (!target) {
+        const auto l = labels_.find(e.target);
+        if (l == labels_.end()) {
+          problems[i] = "unknown target '" + e.target + "'";
+          return;
+        }
+        target = l->second;
+      }
+
+      if (rom.size() <= target->linear()) {
+        problems[i] = "target '" + e.target + "' is not in ROM";
+        return;
+      }
+
+      const auto encoded = encoder.encode(e.text);
+      if (!encoded) {
+        problems[i] = "text can't be encoded with this charmap: " + e.text;
+        return;
+      }
+
+      const std::size_t budget = space(v, *target, language);
+      if (budget == 0) {
+        problems[i] = "no terminated string at '" + e.target + "'";
+        return;
+      }
+
+      if (encoded->size() + 1 > budget) {
+        std::ostringstream os{};
+        os << "text needs " << encoded->size() + 1 << " bytes but only "
+           << budget << " are available at '" << e.target << "'";
+        problems[i] = os.str();
+        return;
+      }
+
+      bytes data(encoded->begin(), encoded->end());
+      data.resize(budget, B(language.end()));
+
+      const bool same = v.from(*target).length(budget).raw().compare(data) == 0;
+
+      plan[i] = {*target, data, e.line, same};
+    };
+
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /* edits are handed out in chunks, as most of them take next to no time
+     * on their own. */
+    constexpr std::size_t chunk = 64;
+    std::atomic<std::size_t> next{0};
+    const auto work = [&]() {
+      for (std::size_t c; (c = next.fetch_add(chunk)) < edits_.size();) {
+        for (std::size_t i = c; i < std::min(c + chunk, edits_.size()); i++) {
+          check(i);
+        }
+      }
+    };
+
+    std::vector<std::thread> pool{};
+    for (std::size_t t = 1; t < std::min(threads, edits_.size() / chunk);
+         t++) {
+      pool.emplace_back(work);
+    }
+
+    work();
+
+    for (auto &t : pool) {
+      t.join();
+    }
+
+    for (std::size_t i = 0; i < edits_.size(); i++) {
+      if (!problems[i].empty()) {
+        errors_.push_back({edits_[i].line, problems[i]});
+      }
+    }
+
+    plan.erase(std::remove_if(plan.begin(), plan.end(),
+                              [](const auto &p) { return p.data.empty(); }),
+               plan.end());
+
+    std::sort(plan.begin(), plan.end(), [](const auto &a, const auto &b) {
+      return a.target < b.target;
+    });
+
+    for (std::size_t i = 1; i < plan.size(); i++) {
+      const auto &a = plan[i - 1];
+      const auto &b = plan[i];
+
+      if (b.target.linear() < a.target.linear() + a.data.size()) {
+        std::ostringstream os{};
+        os << "edit overlaps the edit on line " << a.line;
+        errors_.push_back({b.line, os.str()});
+      }
+    }
+
+    if (errors_.size() > syntax) {
+      std::sort(errors_.begin(), errors_.end(),
+                [](const auto &a, const auto &b) { return a.line < b.line; });
+      return false;
+    }
+
+    /* edits that wouldn't change anything were still checked for overlaps,
+     * but aren't written, so e.g. importing a translation file that nobody
+     * has touched leaves the ROM as it is. */
+    plan.erase(std::remove_if(plan.begin(), plan.end(),
+                              [](const auto &p) { return p.same; }),
+               plan.end());
+
+    applied_ = plan.size();
+
+    if (plan.empty()) {
+      return true;
+    }
+
+    rom.checkpoint();
+
+    for (const auto &p : plan) {
+      rom.write(p.target, p.data);
+    }
+
+    rom.fixHeaderChecksum();
+    rom.fixChecksum();
+
+    rom.checkpoint();
+
+    return true;
+  }
+
+  /* space available for a string at @p.
+   *
+   * This is the length of the existing string, including its terminator, or 0
+   * if there's no properly terminated string there.
+   */
+  static std::size_t space(
+      const view &v, const pointer p,
+      const text::language &language = text::languages::english) {
+    std::size_t n = 0;
+
+    for (const auto b : v.from(p)) {
+      n++;
+
+      if (b == language.end()) {
+        return n;
+      }
+
+      if (language.ends(b)) {
+        break;
+      }
+    }
+
+    return 0;
+  }
+
+  /* the syntax errors load() found, and the problems the last apply() found,
+   * by line. */
+  const std::vector<error> &errors(void) const { return errors_; }
+
+  std::size_t size(void) const { return edits_.size(); }
+
+  /* how many edits the last apply() wrote, not counting skipped ones; 0 if
+   * it failed. */
+  std::size_t applied(void) const { return applied_; }
+
+ protected:
+  std::vector<edit> edits_{};
+  std::map<std::string, pointer> labels_{};
+  std::vector<error> syntax_{};
+  std::vector<error> errors_{};
+  std::size_t line_{0};
+  std::size_t applied_{0};
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
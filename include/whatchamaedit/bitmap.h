@@ -0,0 +1,206 @@
+/* Bitmaps
+ *
+ * A minimal greyscale bitmap with just enough of an encoder to write PGM and
+ * PNG files, so that graphics can be exported without pulling in an image
+ * library. The PNG encoder doesn't compress - it writes stored deflate blocks
+ * - which is perfectly fine for the few hundred kilobytes of graphics in a
+ * GameBoy ROM.
+ *
+ * Pixels are GameBoy shades, i.e. 0 is the lightest and 3 the darkest.
+ */
+
+#if !defined(WHATCHAMAEDIT_BITMAP_H)
+#define WHATCHAMAEDIT_BITMAP_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace graphics {
+class bitmap {
+ public:
+  bitmap(void) : width_{0}, height_{0}, pixels_{} {}
+
+  bitmap(const std::size_t width, const std::size_t height)
+      : width_{width}, height_{height}, pixels_(width * height, 0) {}
+
+  std::size_t width(void) const { return width_; }
+  std::size_t height(void) const { return height_; }
+
+  uint8_t &operator()(const std::size_t x, const std::size_t y) {
+    return pixels_[y * width_ + x];
+  }
+
+  uint8_t operator()(const std::size_t x, const std::size_t y) const {
+    return pixels_[y * width_ + x];
+  }
+
+  uint8_t *row(const std::size_t y) { return pixels_.data() + y * width_; }
+
+  /* copy another bitmap into this one, clipping at the edges. */
+  void blit(const bitmap &b, const std::size_t x, const std::size_t y) {
+    for (std::size_t r = 0; r < b.height_ && y + r < height_; r++) {
+      for (std::size_t c = 0; c < b.width_ && x + c < width_; c++) {
+        (*this)(x + c, y + r) = b(c, r);
+      }
+    }
+  }
+
+  /* lay out a number of bitmaps in a grid.
+   *
+   * Every cell in the grid is as large as the largest bitmap, and the bitmaps
+   * are placed in the top left corner of their cell.
+   */
+  static bitmap sheet(const std::vector<bitmap> &bitmaps,
+                      const std::size_t columns) {
+    std::size_t w = 0, h = 0;
+
+    for (const auto &b : bitmaps) {
+      w = std::max(w, b.width_);
+      h = std::max(h, b.height_);
+    }
+
+    const std::size_t rows = (bitmaps.size() + columns - 1) / columns;
+    bitmap rv{w * columns, h * rows};
+
+    for (std::size_t i = 0; i < bitmaps.size(); i++) {
+      rv.blit(bitmaps[i], (i % columns) * w, (i / columns) * h);
+    }
+
+    return rv;
+  }
+
+  /* the greyscale value for a pixel. */
+  static constexpr uint8_t grey(const uint8_t shade) {
+    return uint8_t(0xff - (shade & 3) * 0x55);
+  }
+
+  bool pgm(std::ostream &out) const {
+    out << "P5\n" << width_ << " " << height_ << "\n255\n";
+
+    std::vector<char> line(width_);
+    for (std::size_t y = 0; y < height_; y++) {
+      for (std::size_t x = 0; x < width_; x++) {
+        line[x] = char(grey((*this)(x, y)));
+      }
+      out.write(line.data(), line.size());
+    }
+
+    return bool(out);
+  }
+
+  bool png(std::ostream &out) const {
+    static const uint8_t signature[8]{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a,
+                                      '\n'};
+
+    out.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    std::string ihdr{};
+    be32(ihdr, width_);
+    be32(ihdr, height_);
+    ihdr += char(8);  // bit depth
+    ihdr += char(0);  // greyscale
+    ihdr += char(0);  // deflate
+    ihdr += char(0);  // adaptive filtering
+    ihdr += char(0);  // no interlacing
+    chunk(out, "IHDR", ihdr);
+
+    // scanlines with filter type 0, which means 'none'
+    std::string raw{};
+    raw.reserve((width_ + 1) * height_);
+    for (std::size_t y = 0; y < height_; y++) {
+      raw += char(0);
+      for (std::size_t x = 0; x < width_; x++) {
+        raw += char(grey((*this)(x, y)));
+      }
+    }
+
+    // zlib stream of stored deflate blocks
+    std::string z{"\x78\x01", 2};
+    for (std::size_t o = 0; o < raw.size() || o == 0; o += 0xffff) {
+      const std::size_t n = std::min<std::size_t>(0xffff, raw.size() - o);
+      z += char(o + n >= raw.size() ? 1 : 0);
+      z += char(n & 0xff);
+      z += char(n >> 8);
+      z += char(~n & 0xff);
+      z += char((~n >> 8) & 0xff);
+      z.append(raw, o, n);
+    }
+    be32(z, adler32(raw));
+    chunk(out, "IDAT", z);
+
+    chunk(out, "IEND", "");
+
+    return bool(out);
+  }
+
+  /* write to a file, as PNG unless the name ends in .pgm. */
+  bool save(const std::string &file) const {
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    const bool isPGM =
+        file.size() >= 4 && file.compare(file.size() - 4, 4, ".pgm") == 0;
+
+    return isPGM ? pgm(out) : png(out);
+  }
+
+ protected:
+  std::size_t width_;
+  std::size_t height_;
+  std::vector<uint8_t> pixels_;
+
+  static void be32(std::string &s, const uint32_t v) {
+    s += char(v >> 24);
+    s += char(v >> 16);
+    s += char(v >> 8);
+    s += char(v);
+  }
+
+  static uint32_t crc32(const std::string &s, uint32_t crc = 0xffffffff) {
+    static const auto table = [] {
+      std::array<uint32_t, 256> t{};
+      for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+          c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        }
+        t[n] = c;
+      }
+      return t;
+    }();
+
+    for (const auto c : s) {
+      crc = table[(crc ^ uint8_t(c)) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+  }
+
+  static uint32_t adler32(const std::string &s) {
+    uint32_t a = 1, b = 0;
+
+    for (const auto c : s) {
+      a = (a + uint8_t(c)) % 65521;
+      b = (b + a) % 65521;
+    }
+
+    return b << 16 | a;
+  }
+
+  static void chunk(std::ostream &out, const std::string &type,
+                    const std::string &data) {
+    std::string s{};
+    be32(s, data.size());
+    s += type;
+    s += data;
+    be32(s, ~crc32(s.substr(4)));
+
+    out.write(s.data(), s.size());
+  }
+};
+}  // namespace graphics
+
+#endif
@@ -0,0 +1,438 @@
+/* On-disk analysis cache
+ *
+ * Everything we derive from a ROM - header fields, string candidates and the
+ * decoded strings - is a pure function of the ROM's contents and of the
+ * library doing the analysis. This header stores those results in a snapshot
+ * file keyed by a hash of the ROM contents and of the language its text is
+ * decoded as, so that repeat runs over the same ROM can skip the analysis
+ * entirely.
+ *
+ * Snapshots are flat, offset-based tables in host byte order. They are
+ * mmap()ed and used in place, there is no deserialisation step.
+ */
+
+#if !defined(WHATCHAMAEDIT_CACHE_H)
+#define WHATCHAMAEDIT_CACHE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <whatchamaedit/version.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace whatchamaedit {
+namespace cache {
+/* hash some ROM contents.
+ *
+ * This is MurmurHash64A, which reads its input a word at a time and is thus
+ * considerably quicker than byte-wise hashes on multi-megabyte ROMs. It's not a
+ * cryptographic hash, but we only use it to tell ROMs apart, and we also
+ * compare sizes on top of that.
+ */
+template <typename B>
+static uint64_t hash(const std::basic_string_view<B> data,
+                     const uint64_t seed = 0x6d65646974ull) {
+  static constexpr uint64_t m = 0xc6a4a7935bd1e995ull;
+  static constexpr int r = 47;
+
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data.data());
+  const std::size_t len = data.size() * sizeof(B);
+
+  uint64_t h = seed ^ (len * m);
+
+  std::size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t k;
+    std::memcpy(&k, bytes + i, sizeof(k));
+
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+
+    h ^= k;
+    h *= m;
+  }
+
+  if (i < len) {
+    uint64_t k = 0;
+    std::memcpy(&k, bytes + i, len - i);
+    h ^= k;
+    h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  return h;
+}
+
+/* default location for snapshots.
+ *
+ * Follows the XDG base directory convention, falling back to the current
+ * directory if we don't even have a $HOME.
+ */
+static std::string directory(void) {
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::string(xdg) + "/whatchamaedit";
+  }
+
+  if (const char *home = std::getenv("HOME"); home && *home) {
+    return std::string(home) + "/.cache/whatchamaedit";
+  }
+
+  return ".whatchamaedit-cache";
+}
+
+static std::string path(const std::string &dir, const uint64_t hash) {
+  std::ostringstream os{};
+
+  os << dir << "/" << std::hex << std::setfill('0') << std::setw(16) << hash
+     << ".wmdb";
+
+  return os.str();
+}
+
+namespace format {
+/* revision of the on-disk layout below.
+ *
+ * Bump this whenever any of the structures in this namespace change. Changes
+ * to the analysis itself should bump whatchamaedit::version instead, which is
+ * also recorded in every snapshot.
+ */
+static const uint32_t revision = 1;
+
+static constexpr char magic[8] = {'W', 'M', 'E', 'D', 'B', 0, 0, 0};
+
+static constexpr uint8_t none = 0xff;
+
+struct section {
+  uint32_t offset;
+  uint32_t count;
+};
+
+struct header {
+  char magic[8];
+  uint32_t revision;
+  uint32_t version;
+  uint64_t hash;
+  uint64_t size;
+  section regions;
+  section strings;
+  section text;
+  uint32_t order;
+  uint32_t reserved;
+};
+
+/* a typed, labelled region of the ROM; currently the header fields. */
+struct region {
+  uint32_t start;
+  uint32_t end;
+  uint32_t label;
+  uint16_t labelLength;
+  uint8_t type;
+  uint8_t endianness;
+};
+
+/* a decoded string; the text itself lives in the text section. */
+struct string {
+  uint32_t pointer;
+  uint32_t offset;
+  uint32_t length;
+};
+
+static_assert(sizeof(header) == 64, "snapshot header must be 64 bytes");
+static_assert(sizeof(region) == 16, "snapshot regions must be 16 bytes");
+static_assert(sizeof(string) == 12, "snapshot strings must be 12 bytes");
+
+/* written as-is, so a snapshot from a host with a different byte order will
+ * fail to validate instead of being misread. */
+static constexpr uint32_t order = 0x01020304;
+}  // namespace format
+
+/* a table in a mapped snapshot.
+ *
+ * Only ever points into the mapping, so it's as cheap to copy as a
+ * std::string_view.
+ */
+template <typename T>
+class table {
+ public:
+  constexpr table(void) : data_{nullptr}, count_{0} {}
+  constexpr table(const T *data, const std::size_t count)
+      : data_{data}, count_{count} {}
+
+  constexpr const T *begin(void) const { return data_; }
+  constexpr const T *end(void) const { return data_ + count_; }
+  constexpr std::size_t size(void) const { return count_; }
+  constexpr bool empty(void) const { return count_ == 0; }
+
+  constexpr const T &operator[](const std::size_t i) const { return data_[i]; }
+
+ protected:
+  const T *data_;
+  std::size_t count_;
+};
+
+/* a mapped, read-only analysis snapshot.
+ *
+ * Construction maps the file and validates it against the ROM it's supposed
+ * to describe; if anything is off - wrong hash, wrong library version, tables
+ * that point outside the file - the snapshot evaluates to false and must be
+ * rebuilt.
+ */
+class snapshot {
+ public:
+  snapshot(const std::string &file, const uint64_t hash, const uint64_t size)
+      : data_{nullptr}, size_{0} {
+    const int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size >= off_t(sizeof(format::header))) {
+      void *m = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m != MAP_FAILED) {
+        data_ = static_cast<const char *>(m);
+        size_ = st.st_size;
+      }
+    }
+
+    ::close(fd);
+
+    if (data_ && !valid(hash, size)) {
+      unmap();
+    }
+  }
+
+  snapshot(const snapshot &) = delete;
+  snapshot &operator=(const snapshot &) = delete;
+
+  snapshot(snapshot &&s) : data_{s.data_}, size_{s.size_} {
+    s.data_ = nullptr;
+    s.size_ = 0;
+  }
+
+  ~snapshot(void) { unmap(); }
+
+  operator bool(void) const { return data_ != nullptr; }
+
+  /* the tables below are all empty if the snapshot isn't valid. */
+  table<format::region> regions(void) const {
+    return data_ ? get<format::region>(header().regions)
+                 : table<format::region>{};
+  }
+
+  table<format::string> strings(void) const {
+    return data_ ? get<format::string>(header().strings)
+                 : table<format::string>{};
+  }
+
+  std::string_view text(const format::string &s) const {
+    return data_ ? text().substr(s.offset, s.length) : std::string_view{};
+  }
+
+  std::string_view label(const format::region &r) const {
+    return data_ ? text().substr(r.label, r.labelLength) : std::string_view{};
+  }
+
+  /* write a snapshot for a ROM.
+   *
+   * @file where to write the snapshot to; the directory is created if needed.
+   * @hash the hash of @rom and its language, as calculated by open().
+   * @rom the ROM to analyse; needs to be a whatchamaedit::rom::gb or similar.
+   *
+   * The snapshot is written to a temporary file first and then renamed into
+   * place, so concurrent readers never see a partial snapshot.
+   */
+  template <typename R>
+  static bool write(const std::string &file, const uint64_t hash,
+                    const R &rom) {
+    std::vector<format::region> regions{};
+    std::vector<format::string> strings{};
+    std::string text{};
+
+    for (const auto &f : rom.header.fields()) {
+      const auto a = f.expected();
+      format::region r{uint32_t(f.startPtr().linear()),
+                       uint32_t(f.endPtr().linear()),
+                       uint32_t(text.size()),
+                       0,
+                       format::none,
+                       format::none};
+
+      if (a.label) {
+        r.labelLength = uint16_t(a.label->size());
+        text += *a.label;
+      }
+      if (a.type) {
+        r.type = uint8_t(*a.type);
+      }
+      if (a.endianness) {
+        r.endianness = uint8_t(*a.endianness);
+      }
+
+      regions.push_back(r);
+    }
+
+    for (const auto &s : rom.getStrings()) {
+      strings.push_back({uint32_t(s.first.linear()), uint32_t(text.size()),
+                         uint32_t(s.second.size())});
+      text += s.second;
+    }
+
+    format::header h{};
+    std::memcpy(h.magic, format::magic, sizeof(h.magic));
+    h.revision = format::revision;
+    h.version = whatchamaedit::version;
+    h.hash = hash;
+    h.size = rom.size();
+    h.order = format::order;
+
+    uint32_t offset = sizeof(h);
+    h.regions = {offset, uint32_t(regions.size())};
+    offset += align(regions.size() * sizeof(format::region));
+    h.strings = {offset, uint32_t(strings.size())};
+    offset += align(strings.size() * sizeof(format::string));
+    h.text = {offset, uint32_t(text.size())};
+
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path(file).parent_path(), ec);
+
+    const std::string tmp = file + ".tmp." + std::to_string(::getpid());
+
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+
+      out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+      out.write(reinterpret_cast<const char *>(regions.data()),
+                regions.size() * sizeof(format::region));
+      pad(out);
+      out.write(reinterpret_cast<const char *>(strings.data()),
+                strings.size() * sizeof(format::string));
+      pad(out);
+      out.write(text.data(), text.size());
+
+      if (!out) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+      }
+    }
+
+    std::filesystem::rename(tmp, file, ec);
+
+    return !ec;
+  }
+
+  /* open the snapshot for a ROM, building it first if necessary.
+   *
+   * @dir the cache directory to use.
+   * @rom the ROM to open a snapshot for.
+   */
+  template <typename R>
+  static snapshot open(const std::string &dir, const R &rom) {
+    const std::string_view language = rom.language().name();
+    const uint64_t h = cache::hash(rom.readonly(), cache::hash(language));
+    const std::string file = path(dir, h);
+
+    snapshot s{file, h, rom.size()};
+
+    if (!s && write(file, h, rom)) {
+      return snapshot{file, h, rom.size()};
+    }
+
+    return s;
+  }
+
+ protected:
+  const char *data_;
+  std::size_t size_;
+
+  const format::header &header(void) const {
+    return *reinterpret_cast<const format::header *>(data_);
+  }
+
+  std::string_view text(void) const {
+    if (!data_) {
+      return {};
+    }
+
+    return {data_ + header().text.offset, header().text.count};
+  }
+
+  template <typename T>
+  table<T> get(const format::section &s) const {
+    return {reinterpret_cast<const T *>(data_ + s.offset), s.count};
+  }
+
+  static constexpr uint32_t align(const std::size_t n) {
+    return uint32_t((n + 7) & ~std::size_t(7));
+  }
+
+  static void pad(std::ostream &out) {
+    static const char zero[8]{};
+    out.write(zero, (8 - out.tellp() % 8) % 8);
+  }
+
+  bool fits(const format::section &s, const std::size_t unit) const {
+    return s.offset <= size_ && s.count <= (size_ - s.offset) / unit &&
+           s.offset % alignof(uint64_t) == 0;
+  }
+
+  bool valid(const uint64_t hash, const uint64_t size) const {
+    const auto &h = header();
+
+    if (std::memcmp(h.magic, format::magic, sizeof(h.magic)) != 0 ||
+        h.order != format::order || h.revision != format::revision ||
+        h.version != whatchamaedit::version || h.hash != hash ||
+        h.size != size) {
+      return false;
+    }
+
+    if (!fits(h.regions, sizeof(format::region)) ||
+        !fits(h.strings, sizeof(format::string)) ||
+        h.text.offset > size_ || h.text.count > size_ - h.text.offset) {
+      return false;
+    }
+
+    for (const auto &s : strings()) {
+      if (s.offset > h.text.count || s.length > h.text.count - s.offset) {
+        return false;
+      }
+    }
+
+    for (const auto &r : regions()) {
+      if (r.label > h.text.count || r.labelLength > h.text.count - r.label) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void unmap(void) {
+    if (data_) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+  }
+};
+}  // namespace cache
+}  // namespace whatchamaedit
+
+#endif
@@ -5,8 +5,10 @@
 #include <array>
 #include <map>
 #include <optional>
+#include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace text {
 using codepoint = unsigned long;
@@ -147,10 +149,166 @@ class code {
     }
   }
 
+  /* all runes in the code, in order. */
+  constexpr const set &runes(void) const { return data_; }
+
  protected:
   set data_;
 };
 
+/* reverse lookup for a charmap.
+ *
+ * Encodes text by always consuming the longest glyph that matches, so that
+ * e.g. "POKé" becomes the single POKé rune instead of four letters. Where
+ * several runes share a glyph, the canonical one wins: Gen I charmaps keep
+ * their regular characters in 0x80 - 0xff and alternate forms of some of them
+ * below that, so runes in the upper half are preferred, and the lowest of
+ * those, e.g. 0xe8 for "." rather than the decimal point at 0xf2. That way,
+ * text that is decoded and encoded again comes out as the same bytes.
+ *
+ * Candidates are bucketed by their first byte, so encoding only ever has to
+ * look at a handful of glyphs per character.
+ */
+class encoder {
+ public:
+  using bytes = std::basic_string<uint8_t>;
+
+  encoder(charmap &map) : candidates_{} {
+    for (const auto &p : map) {
+      if (p.second.empty()) {
+        continue;
+      }
+
+      auto &bucket = candidates_[uint8_t(p.second.front())];
+      auto it = std::find_if(bucket.begin(), bucket.end(), [&p](const auto &c) {
+        return c.first == p.second;
+      });
+
+      if (it == bucket.end()) {
+        bucket.push_back({p.second, uint8_t(p.first)});
+      } else {
+        it->second = std::min(it->second, uint8_t(p.first), canonical);
+      }
+    }
+
+    for (auto &bucket : candidates_) {
+      std::sort(bucket.begin(), bucket.end(), [](const auto &a, const auto &b) {
+        return a.first.size() > b.first.size();
+      });
+    }
+  }
+
+  /* encode some text.
+   *
+   * Returns nothing if any part of @s can't be represented with this charmap.
+   */
+  std::optional<bytes> encode(std::string_view s) const {
+    bytes rv{};
+    rv.reserve(s.size());
+
+    while (!s.empty()) {
+      bool found = false;
+
+      for (const auto &c : candidates_[uint8_t(s.front())]) {
+        if (s.rfind(c.first, 0) == 0) {
+          rv.push_back(c.second);
+          s.remove_prefix(c.first.size());
+          found = true;
+          break;
+        }
+      }
+
+      if (!found) {
+        return {};
+      }
+    }
+
+    return rv;
+  }
+
+ protected:
+  std::array<std::vector<std::pair<std::string_view, uint8_t>>, 256>
+      candidates_;
+
+  /* whether rune @a is preferred over rune @b for the same glyph. */
+  static bool canonical(const uint8_t a, const uint8_t b) {
+    return (a >= 0x80) != (b >= 0x80) ? a >= 0x80 : a < b;
+  }
+};
+
+/* flat lookup table for a charmap.
+ *
+ * Charmaps are std::maps, so looking up every byte of a string in one means a
+ * tree walk per byte; this has an entry for every byte value instead, so
+ * decoding a byte is a single index into a table.
+ */
+class decoder {
+ public:
+  decoder(charmap &map) {
+    for (const auto &p : map) {
+      if (p.first < glyphs_.size()) {
+        glyphs_[p.first] = p.second;
+        defined_[p.first] = true;
+      }
+    }
+  }
+
+  /* whether @b is in the charmap at all, even if only as a control code. */
+  bool defined(const uint8_t b) const { return defined_[b]; }
+
+  /* the glyph for @b, which is empty for bytes that aren't in the charmap. */
+  std::string_view operator[](const uint8_t b) const { return glyphs_[b]; }
+
+ protected:
+  std::array<std::string_view, 256> glyphs_{};
+  std::array<bool, 256> defined_{};
+};
+
+/* a charmap, and what text that uses it looks like.
+ *
+ * Strings are runs of bytes that are in the charmap, up to the end byte. Of
+ * those bytes, the text() ones are letters and digits, which is what tells
+ * actual strings apart from data that just happens to be in the charmap. The
+ * words() are snippets that are common in the language, spaces and all; they
+ * tell apart languages that share most of a charmap, like English and French.
+ */
+class language {
+ public:
+  language(const std::string_view name, charmap &map, const uint8_t end,
+           bool (*const text)(uint8_t),
+           const std::vector<std::string_view> words)
+      : name_{name}, map_{map}, glyphs_{map}, end_{end}, words_{words} {
+    for (std::size_t b = 0; b < text_.size(); b++) {
+      text_[b] = text(uint8_t(b));
+      ends_[b] = b == 0 || !glyphs_.defined(uint8_t(b)) || b == end;
+    }
+  }
+
+  std::string_view name(void) const { return name_; }
+
+  charmap &map(void) const { return map_; }
+
+  const decoder &glyphs(void) const { return glyphs_; }
+
+  uint8_t end(void) const { return end_; }
+
+  const std::vector<std::string_view> &words(void) const { return words_; }
+
+  bool text(const uint8_t b) const { return text_[b]; }
+
+  /* whether @b ends any string it's in. */
+  bool ends(const uint8_t b) const { return ends_[b]; }
+
+ protected:
+  std::string_view name_;
+  charmap &map_;
+  decoder glyphs_;
+  uint8_t end_;
+  std::array<bool, 256> text_{};
+  std::array<bool, 256> ends_{};
+  std::vector<std::string_view> words_;
+};
+
 namespace encoding {
 
 static constexpr const code<unsigned long, 0x80> ascii{{
@@ -305,6 +463,14 @@ static_assert(ascii.special(0x7f) && !ascii.glyph(0x7f),
 static_assert(!ascii.special(0x64) && ascii.glyph(0x64),
               "ASCII 0x64 is a printable glyph");
 static_assert(!ascii.defined(0x80), "ASCII is only valid betweem 0x00 - 0x7f");
+
+/* ASCII as a charmap, for decoders and encoders. */
+static charmap asciiMap(ascii.runes().begin(), ascii.runes().end());
+
+static constexpr bool isASCIIText(uint8_t b) {
+  return ('0' <= b && b <= '9') || ('A' <= b && b <= 'Z') ||
+         ('a' <= b && b <= 'z');
+}
 }  // namespace encoding
 
 namespace pokemon {
@@ -482,6 +648,253 @@ static constexpr bool isText(uint8_t b) {
   return (0x80 <= b && b <= 0xbf) || (0xf6 <= b && b <= 0xff);
 };
 
+/* the French and German versions share a charmap, which is the English one
+ * with accented letters in place of most contractions, and French ones in
+ * what's unused in English. */
+static charmap european = [] {
+  std::map<codepoint, const std::string_view> m{english.begin(),
+                                                english.end()};
+
+  for (const auto &p : std::map<codepoint, const std::string_view>{
+           {0xba, "à"},  {0xbb, "è"},  {0xbc, "é"},  {0xbd, "ù"},
+           {0xbe, "ß"},  {0xbf, "ç"},  {0xc0, "Ä"},  {0xc1, "Ö"},
+           {0xc2, "Ü"},  {0xc3, "ä"},  {0xc4, "ö"},  {0xc5, "ü"},
+           {0xc6, "ë"},  {0xc7, "ï"},  {0xc8, "â"},  {0xc9, "ô"},
+           {0xca, "û"},  {0xcb, "ê"},  {0xcc, "î"},  {0xd4, "c'"},
+           {0xd5, "d'"}, {0xd6, "j'"}, {0xd7, "l'"}, {0xd8, "m'"},
+           {0xd9, "n'"}, {0xda, "p'"}, {0xdb, "s'"}, {0xdc, "'s"},
+           {0xdd, "t'"}, {0xde, "u'"}, {0xdf, "y'"},
+       }) {
+    m.erase(p.first);
+    m.insert(p);
+  }
+
+  return m;
+}();
+
+static constexpr bool isEuropeanText(uint8_t b) {
+  return (0x80 <= b && b <= 0xcc) || (0xd4 <= b && b <= 0xdf) || 0xf6 <= b;
+}
+
+/* the Japanese versions have the same control codes, but kana instead of
+ * letters. Voiced kana are in 0x01 - 0x48, as in pokered's charmap.asm; the
+ * katakana ベ and ペ are written with the hiragana べ and ぺ, which look the
+ * same, so that's how they need to be written on import as well. */
+static charmap japanese({
+    {0x00, ""},
+
+    {0x01, "イ゛"},
+    {0x02, "ヴ"},
+    {0x03, "エ゛"},
+    {0x04, "オ゛"},
+    {0x05, "ガ"},
+    {0x06, "ギ"},
+    {0x07, "グ"},
+    {0x08, "ゲ"},
+    {0x09, "ゴ"},
+    {0x0a, "ザ"},
+    {0x0b, "ジ"},
+    {0x0c, "ズ"},
+    {0x0d, "ゼ"},
+    {0x0e, "ゾ"},
+    {0x0f, "ダ"},
+    {0x10, "ヂ"},
+    {0x11, "ヅ"},
+    {0x12, "デ"},
+    {0x13, "ド"},
+
+    {0x19, "バ"},
+    {0x1a, "ビ"},
+    {0x1b, "ブ"},
+    {0x1c, "ボ"},
+
+    {0x26, "が"},
+    {0x27, "ぎ"},
+    {0x28, "ぐ"},
+    {0x29, "げ"},
+    {0x2a, "ご"},
+    {0x2b, "ざ"},
+    {0x2c, "じ"},
+    {0x2d, "ず"},
+    {0x2e, "ぜ"},
+    {0x2f, "ぞ"},
+    {0x30, "だ"},
+    {0x31, "ぢ"},
+    {0x32, "づ"},
+    {0x33, "で"},
+    {0x34, "ど"},
+
+    {0x3a, "ば"},
+    {0x3b, "び"},
+    {0x3c, "ぶ"},
+    {0x3d, "べ"},
+    {0x3e, "ぼ"},
+
+    {0x40, "パ"},
+    {0x41, "ピ"},
+    {0x42, "プ"},
+    {0x43, "ポ"},
+    {0x44, "ぱ"},
+    {0x45, "ぴ"},
+    {0x46, "ぷ"},
+    {0x47, "ぺ"},
+    {0x48, "ぽ"},
+
+    {0x49, "{page+}"},
+    {0x4b, "{_cont}"},
+    {0x4c, "{autocont}"},
+    {0x4e, "{line+}"},
+    {0x4f, "{line++}"},
+    {0x50, "{end}"},
+    {0x51, "{para}"},
+    {0x52, "{player}"},
+    {0x53, "{rival}"},
+    {0x54, "ポケモン"},
+    {0x55, "{+cont}"},
+    {0x57, "{done}"},
+    {0x58, "{$prompt}"},
+    {0x59, "{target}"},
+    {0x5a, "{user}"},
+    {0x5f, "{dex-}"},
+
+    {0x7f, " "},
+
+    {0x80, "ア"},
+    {0x81, "イ"},
+    {0x82, "ウ"},
+    {0x83, "エ"},
+    {0x84, "オ"},
+    {0x85, "カ"},
+    {0x86, "キ"},
+    {0x87, "ク"},
+    {0x88, "ケ"},
+    {0x89, "コ"},
+    {0x8a, "サ"},
+    {0x8b, "シ"},
+    {0x8c, "ス"},
+    {0x8d, "セ"},
+    {0x8e, "ソ"},
+    {0x8f, "タ"},
+    {0x90, "チ"},
+    {0x91, "ツ"},
+    {0x92, "テ"},
+    {0x93, "ト"},
+    {0x94, "ナ"},
+    {0x95, "ニ"},
+    {0x96, "ヌ"},
+    {0x97, "ネ"},
+    {0x98, "ノ"},
+    {0x99, "ハ"},
+    {0x9a, "ヒ"},
+    {0x9b, "フ"},
+    {0x9c, "ホ"},
+    {0x9d, "マ"},
+    {0x9e, "ミ"},
+    {0x9f, "ム"},
+    {0xa0, "メ"},
+    {0xa1, "モ"},
+    {0xa2, "ヤ"},
+    {0xa3, "ユ"},
+    {0xa4, "ヨ"},
+    {0xa5, "ラ"},
+    {0xa6, "ル"},
+    {0xa7, "レ"},
+    {0xa8, "ロ"},
+    {0xa9, "ワ"},
+    {0xaa, "ヲ"},
+    {0xab, "ン"},
+    {0xac, "ッ"},
+    {0xad, "ャ"},
+    {0xae, "ュ"},
+    {0xaf, "ョ"},
+    {0xb0, "ィ"},
+    {0xb1, "あ"},
+    {0xb2, "い"},
+    {0xb3, "う"},
+    {0xb4, "え"},
+    {0xb5, "お"},
+    {0xb6, "か"},
+    {0xb7, "き"},
+    {0xb8, "く"},
+    {0xb9, "け"},
+    {0xba, "こ"},
+    {0xbb, "さ"},
+    {0xbc, "し"},
+    {0xbd, "す"},
+    {0xbe, "せ"},
+    {0xbf, "そ"},
+    {0xc0, "た"},
+    {0xc1, "ち"},
+    {0xc2, "つ"},
+    {0xc3, "て"},
+    {0xc4, "と"},
+    {0xc5, "な"},
+    {0xc6, "に"},
+    {0xc7, "ぬ"},
+    {0xc8, "ね"},
+    {0xc9, "の"},
+    {0xca, "は"},
+    {0xcb, "ひ"},
+    {0xcc, "ふ"},
+    {0xcd, "へ"},
+    {0xce, "ほ"},
+    {0xcf, "ま"},
+    {0xd0, "み"},
+    {0xd1, "む"},
+    {0xd2, "め"},
+    {0xd3, "も"},
+    {0xd4, "や"},
+    {0xd5, "ゆ"},
+    {0xd6, "よ"},
+    {0xd7, "ら"},
+    {0xd8, "り"},
+    {0xd9, "る"},
+    {0xda, "れ"},
+    {0xdb, "ろ"},
+    {0xdc, "わ"},
+    {0xdd, "を"},
+    {0xde, "ん"},
+    {0xdf, "っ"},
+    {0xe0, "ゃ"},
+    {0xe1, "ゅ"},
+    {0xe2, "ょ"},
+    {0xe3, "ー"},
+    {0xe4, "゜"},
+    {0xe5, "゛"},
+    {0xe6, "？"},
+    {0xe7, "！"},
+    {0xe8, "。"},
+    {0xe9, "ァ"},
+    {0xea, "ゥ"},
+    {0xeb, "ェ"},
+    {0xec, "▷"},
+    {0xed, "▶"},
+    {0xee, "▼"},
+    {0xef, "♂"},
+    {0xf0, "円"},
+    {0xf1, "×"},
+    {0xf2, "."},
+    {0xf3, "/"},
+    {0xf4, "ォ"},
+    {0xf5, "♀"},
+    {0xf6, "0"},
+    {0xf7, "1"},
+    {0xf8, "2"},
+    {0xf9, "3"},
+    {0xfa, "4"},
+    {0xfb, "5"},
+    {0xfc, "6"},
+    {0xfd, "7"},
+    {0xfe, "8"},
+    {0xff, "9"},
+});
+
+/* voiced kana aren't counted, as bytes that low are just as common in any
+ * other data; they're still part of strings, as they're in the charmap. */
+static constexpr bool isJapaneseText(uint8_t b) {
+  return (0x80 <= b && b <= 0xe2) || 0xf6 <= b;
+}
+
 static uint8_t toROMFormat(std::string &s) {
   std::set<uint8_t> ids;
   std::size_t longest = 1;
@@ -523,6 +936,62 @@ static uint8_t toROMFormat(char c) {
 
 }  // namespace bgry
 }  // namespace pokemon
+
+/* the languages that a ROM's text can be in, as far as charmaps go. */
+namespace languages {
+static const language english{
+    "english",
+    pokemon::bgry::english,
+    pokemon::bgry::end,
+    pokemon::bgry::isText,
+    {" the ", " you ", " to ", " is ", " and ", " of ", " it ", "ing "}};
+
+static const language french{
+    "french",
+    pokemon::bgry::european,
+    pokemon::bgry::end,
+    pokemon::bgry::isEuropeanText,
+    {" le ", " la ", " les ", " de ", " est ", " vous ", " une ", " pas "}};
+
+static const language german{
+    "german",
+    pokemon::bgry::european,
+    pokemon::bgry::end,
+    pokemon::bgry::isEuropeanText,
+    {" der ", " die ", " das ", " und ", " ist ", " du ", " ein", " nicht"}};
+
+static const language japanese{
+    "japanese",
+    pokemon::bgry::japanese,
+    pokemon::bgry::end,
+    pokemon::bgry::isJapaneseText,
+    {"ました", "します", "ません", "でした", "ください", "ている", "という",
+     "だろう"}};
+
+/* plain ASCII, with C strings, for anything that isn't Pokémon. */
+static const language ascii{
+    "ascii",
+    encoding::asciiMap,
+    0,
+    encoding::isASCIIText,
+    {" the ", " you ", " to ", " is ", " and ", " of ", " in ", " for "}};
+
+/* all of the above; English comes first, as it's what's used when nothing
+ * else fits better. */
+static const std::array<const language *, 5> all{&english, &french, &german,
+                                                 &japanese, &ascii};
+
+/* the language called @name, if there is one. */
+static const language *byName(const std::string_view name) {
+  for (const auto *l : all) {
+    if (l->name() == name) {
+      return l;
+    }
+  }
+
+  return nullptr;
+}
+}  // namespace languages
 }  // namespace text
 
 #endif
@@ -0,0 +1,409 @@
+/* Region classifier
+ *
+ * Gives a rough idea of what's where in a ROM by looking at every 256 byte
+ * block on its own and guessing whether it's code, text, graphics, padding, a
+ * pointer table or something else entirely. The guesses are based on simple
+ * statistics - a byte histogram, the share of bytes that are text in the ROM's
+ * charmap, how plausible the block is as 2bpp tiles and how plausible it is as
+ * SM83 code - so they're going to be wrong every now and then, but they're
+ * good enough to skip obviously irrelevant regions and to get an overview of
+ * an unknown ROM.
+ *
+ * Banks are classified concurrently.
+ */
+
+#if !defined(WHATCHAMAEDIT_CLASSIFY_H)
+#define WHATCHAMAEDIT_CLASSIFY_H
+
+#include <whatchamaedit/character-map.h>
+#include <whatchamaedit/view.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace gameboy {
+enum region : uint8_t {
+  r_unknown,
+  r_padding,
+  r_code,
+  r_text,
+  r_graphics,
+  r_pointers,
+};
+
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class classify {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  static constexpr std::size_t blockSize = 256;
+
+  /* the statistics a block's classification is based on. */
+  struct features {
+    /* Shannon entropy, in bits per byte. */
+    double entropy;
+    /* share of the most common byte value. */
+    double dominant;
+    uint8_t dominantByte;
+    /* share of bytes that are text, spaces or line breaks. */
+    double text;
+    /* share of tile rows that look like they're part of a drawing. */
+    double tiles;
+    /* share of decoded instructions that are commonly used ones. */
+    double code;
+    /* whether any instruction decoded to an invalid opcode. */
+    bool invalid;
+    /* share of little endian words that look like banked pointers. */
+    double pointers;
+  };
+
+  /** @constructor
+   *
+   * @rom the ROM to classify.
+   * @language the language the ROM's text is in; only its charmap matters.
+   * @threads number of threads to use; 0 means one per hardware thread.
+   */
+  classify(const view &rom,
+           const text::language &language = text::languages::english,
+           std::size_t threads = 0) {
+    const auto data = rom.raw();
+
+    for (std::size_t b = 0; b < text_.size(); b++) {
+      text_[b] = isText(language, uint8_t(b));
+    }
+
+    const std::size_t bankSize = pointer::bankSize();
+    const std::size_t banks = (data.size() + bankSize - 1) / bankSize;
+
+    blocks_.resize((data.size() + blockSize - 1) / blockSize, r_unknown);
+
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::atomic<std::size_t> next{0};
+    const auto work = [&]() {
+      for (std::size_t bank; (bank = next++) < banks;) {
+        const std::size_t end = std::min((bank + 1) * bankSize, data.size());
+
+        for (std::size_t s = bank * bankSize; s < end; s += blockSize) {
+          const auto block = data.substr(s, std::min(blockSize, end - s));
+          blocks_[s / blockSize] = label(measure(block));
+        }
+      }
+    };
+
+    std::vector<std::thread> pool{};
+    for (std::size_t t = 1; t < std::min(threads, banks); t++) {
+      pool.emplace_back(work);
+    }
+
+    work();
+
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+
+  region at(const pointer p) const {
+    const std::size_t b = p.linear() / blockSize;
+    return b < blocks_.size() ? blocks_[b] : r_unknown;
+  }
+
+  const std::vector<region> &blocks(void) const { return blocks_; }
+
+  std::size_t count(const region r) const {
+    return std::count(blocks_.begin(), blocks_.end(), r);
+  }
+
+  static constexpr char symbol(const region r) {
+    switch (r) {
+      case r_padding:
+        return '.';
+      case r_code:
+        return 'c';
+      case r_text:
+        return 't';
+      case r_graphics:
+        return 'g';
+      case r_pointers:
+        return 'p';
+      case r_unknown:
+        break;
+    }
+
+    return '?';
+  }
+
+  static constexpr std::string_view name(const region r) {
+    switch (r) {
+      case r_padding:
+        return "padding";
+      case r_code:
+        return "code";
+      case r_text:
+        return "text";
+      case r_graphics:
+        return "graphics";
+      case r_pointers:
+        return "pointer table";
+      case r_unknown:
+        break;
+    }
+
+    return "unknown";
+  }
+
+  /* the compact map: one character per block, one line per bank. */
+  std::string map(void) const {
+    const std::size_t perBank = pointer::bankSize() / blockSize;
+    std::string rv{};
+
+    for (std::size_t i = 0; i < blocks_.size(); i++) {
+      rv += symbol(blocks_[i]);
+      if (i % perBank == perBank - 1 || i == blocks_.size() - 1) {
+        rv += '\n';
+      }
+    }
+
+    return rv;
+  }
+
+  /* a colour heatmap as a binary PPM: one row per bank, each block drawn as a
+   * @scale by @scale square. */
+  bool ppm(std::ostream &out, const std::size_t scale = 4) const {
+    static constexpr uint8_t colours[][3]{
+        {0x80, 0x80, 0x80},  // unknown
+        {0x00, 0x00, 0x00},  // padding
+        {0xe0, 0x40, 0x40},  // code
+        {0x40, 0xc0, 0x40},  // text
+        {0x40, 0x80, 0xff},  // graphics
+        {0xff, 0xc0, 0x20},  // pointer table
+    };
+
+    const std::size_t perBank = pointer::bankSize() / blockSize;
+    const std::size_t rows = (blocks_.size() + perBank - 1) / perBank;
+
+    out << "P6\n" << perBank * scale << " " << rows * scale << "\n255\n";
+
+    std::string line(perBank * scale * 3, '\0');
+    for (std::size_t r = 0; r < rows; r++) {
+      for (std::size_t c = 0; c < perBank; c++) {
+        const std::size_t i = r * perBank + c;
+        const auto &rgb = colours[i < blocks_.size() ? blocks_[i] : r_padding];
+
+        for (std::size_t x = 0; x < scale; x++) {
+          std::copy(rgb, rgb + 3, line.begin() + (c * scale + x) * 3);
+        }
+      }
+
+      for (std::size_t y = 0; y < scale; y++) {
+        out.write(line.data(), line.size());
+      }
+    }
+
+    return bool(out);
+  }
+
+  features measure(const std::basic_string_view<B> block) const {
+    features f{};
+    std::array<std::size_t, 256> histogram{};
+
+    for (const auto b : block) {
+      histogram[uint8_t(b)]++;
+    }
+
+    const double n = block.size();
+    std::size_t text = 0;
+
+    for (std::size_t v = 0; v < histogram.size(); v++) {
+      const std::size_t c = histogram[v];
+
+      if (c > 0) {
+        const double p = c / n;
+        f.entropy -= p * std::log2(p);
+      }
+
+      if (c > histogram[f.dominantByte]) {
+        f.dominantByte = uint8_t(v);
+      }
+
+      if (text_[v]) {
+        text += c;
+      }
+    }
+
+    f.dominant = histogram[f.dominantByte] / n;
+    f.text = text / n;
+    f.tiles = tiles(block);
+    f.pointers = pointers(block);
+    code(block, f);
+
+    return f;
+  }
+
+  static region label(const features &f) {
+    if (f.dominant >= 0.95 &&
+        (f.dominantByte == 0x00 || f.dominantByte == 0xff)) {
+      return r_padding;
+    }
+
+    if (f.text >= 0.75) {
+      return r_text;
+    }
+
+    if (f.pointers >= 0.75) {
+      return r_pointers;
+    }
+
+    if (f.tiles >= 0.6 && f.entropy < 7) {
+      return r_graphics;
+    }
+
+    if (!f.invalid && f.code >= 0.35) {
+      return r_code;
+    }
+
+    return r_unknown;
+  }
+
+ protected:
+  std::vector<region> blocks_{};
+
+  /* which bytes measure() counts as text. */
+  std::array<bool, 256> text_{};
+
+  /* whether @b is a letter or digit in @l, its end byte, or one of the spaces
+   * and control codes that lay text out; those are named alike across the
+   * charmaps, so they're picked out by name. An end byte of 0, as in ASCII,
+   * isn't counted, as that's just as common in data that isn't text. */
+  static bool isText(const text::language &l, const uint8_t b) {
+    static constexpr std::string_view layout[]{
+        " ",       "{line+}",    "{line++}",   "{para}",
+        "{+cont}", "{done}",     "{$prompt}",  "{new line}",
+        "{horizontal tab}",      "{carriage return}"};
+
+    return l.text(b) || (b == l.end() && b != 0) ||
+           std::find(std::begin(layout), std::end(layout), l.glyphs()[b]) !=
+               std::end(layout);
+  }
+
+  /* share of 2bpp rows that look drawn rather than random: rows that repeat
+   * the previous one, that are blank or solid in a plane, or that have the
+   * same bits in both planes. */
+  static double tiles(const std::basic_string_view<B> block) {
+    std::size_t plausible = 0, rows = 0;
+
+    for (std::size_t i = 0; i + 1 < block.size(); i += 2, rows++) {
+      const uint8_t lo = block[i], hi = block[i + 1];
+      const bool repeated =
+          i % 16 != 0 && lo == uint8_t(block[i - 2]) &&
+          hi == uint8_t(block[i - 1]);
+
+      if (repeated || lo == hi || lo == 0x00 || hi == 0x00 || lo == 0xff ||
+          hi == 0xff) {
+        plausible++;
+      }
+    }
+
+    return rows > 0 ? double(plausible) / rows : 0;
+  }
+
+  /* share of little endian words with a high byte in the switchable bank
+   * window, with at least some variety in the low bytes. */
+  static double pointers(const std::basic_string_view<B> block) {
+    std::size_t plausible = 0, words = 0, distinct = 0;
+    std::array<bool, 256> seen{};
+
+    for (std::size_t i = 0; i + 1 < block.size(); i += 2, words++) {
+      const uint8_t lo = block[i], hi = block[i + 1];
+
+      if (0x40 <= hi && hi < 0x80) {
+        plausible++;
+        if (!seen[lo]) {
+          seen[lo] = true;
+          distinct++;
+        }
+      }
+    }
+
+    return words > 0 && distinct * 4 >= words ? double(plausible) / words : 0;
+  }
+
+  /* decode a block as SM83 code and count how many instructions are among
+   * the most common ones, and whether there are any that don't exist. */
+  static void code(const std::basic_string_view<B> block, features &f) {
+    static constexpr auto length = [] {
+      std::array<uint8_t, 256> l{};
+      for (auto &v : l) {
+        v = 1;
+      }
+      for (const uint8_t o : {0x06, 0x0e, 0x16, 0x1e, 0x26, 0x2e, 0x36, 0x3e,
+                              0x10, 0x18, 0x20, 0x28, 0x30, 0x38, 0xc6, 0xce,
+                              0xd6, 0xde, 0xe6, 0xee, 0xf6, 0xfe, 0xe0, 0xf0,
+                              0xe8, 0xf8, 0xcb}) {
+        l[o] = 2;
+      }
+      for (const uint8_t o : {0x01, 0x11, 0x21, 0x31, 0x08, 0xc2, 0xc3, 0xca,
+                              0xd2, 0xda, 0xc4, 0xcc, 0xcd, 0xd4, 0xdc, 0xea,
+                              0xfa}) {
+        l[o] = 3;
+      }
+      return l;
+    }();
+
+    static constexpr auto common = [] {
+      std::array<bool, 256> c{};
+      for (const uint8_t o :
+           {0x01, 0x11, 0x21, 0x13, 0x23, 0x18, 0x20, 0x28, 0x30, 0x38, 0x22,
+            0x2a, 0x3c, 0x3d, 0x3e, 0x77, 0x7e, 0xa7, 0xaf, 0xb7, 0xc1, 0xc3,
+            0xc5, 0xc9, 0xca, 0xc2, 0xcb, 0xcd, 0xd1, 0xd5, 0xe0, 0xe1, 0xe5,
+            0xea, 0xf0, 0xf1, 0xf5, 0xfa, 0xfe}) {
+        c[o] = true;
+      }
+      return c;
+    }();
+
+    std::size_t instructions = 0, hits = 0;
+
+    for (std::size_t i = 0; i < block.size(); i += length[uint8_t(block[i])]) {
+      const uint8_t o = block[i];
+
+      switch (o) {
+        case 0xd3:
+        case 0xdb:
+        case 0xdd:
+        case 0xe3:
+        case 0xe4:
+        case 0xeb:
+        case 0xec:
+        case 0xed:
+        case 0xf4:
+        case 0xfc:
+        case 0xfd:
+          f.invalid = true;
+          break;
+        default:
+          break;
+      }
+
+      instructions++;
+      hits += common[o];
+    }
+
+    f.code = instructions > 0 ? double(hits) / instructions : 0;
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -22,19 +22,19 @@ static std::string dump(const gameboy::rom::pointer<B, W, bankSize_> &ptr) {
   }
   os << "=" << std::hex << std::setfill('0');
   if (ptr.isBanked()) {
-    os << "[0x" << std::setw(2) << W(ptr.bank()) << ":" << std::setw(4)
-       << ptr.offset() << "]";
+    os << "[0x" << std::setw(sizeof(B) * 2) << W(ptr.bank()) << ":"
+       << std::setw(4) << ptr.offset() << "]";
   } else {
-    os << " 0x" << std::setw(2) << W(ptr.bank()) << ":" << std::setw(4)
-       << ptr.offset() << " ";
+    os << " 0x" << std::setw(sizeof(B) * 2) << W(ptr.bank()) << ":"
+       << std::setw(4) << ptr.offset() << " ";
   }
   os << "}";
 
   return os.str();
 }
 
-template <typename B, typename W>
-static std::string dump(const gameboy::rom::view<B, W> view) {
+template <typename B, typename W, typename K>
+static std::string dump(const gameboy::rom::view<B, W, K> view) {
   std::ostringstream os{};
   const auto a = view.expected();
 
@@ -135,6 +135,9 @@ static std::string dump(const gameboy::rom::view<B, W> view) {
       case gameboy::dt_text:
         os << " TEXT    ";
         break;
+      case gameboy::dt_tiles:
+        os << " TILES   ";
+        break;
       default:
         os << " UNTYPED ";
     }
@@ -155,6 +158,9 @@ static std::string dump(const gameboy::rom::view<B, W> view) {
       case gameboy::dt_text:
         os << "\"" << std::string(view) << "\"";
         break;
+      case gameboy::dt_tiles:
+        os << std::dec << view.size() / 16 << " tiles";
+        break;
       default:
         break;
     }
@@ -162,6 +168,7 @@ static std::string dump(const gameboy::rom::view<B, W> view) {
     switch (*a.type) {
       case gameboy::dt_bytes:
       case gameboy::dt_words:
+      case gameboy::dt_tiles:
         os << "\t[...]";
         break;
       default:
@@ -174,12 +181,13 @@ static std::string dump(const gameboy::rom::view<B, W> view) {
   return os.str();
 }
 
-template <typename B, typename W, std::size_t count>
-static std::string dump(const std::array<gameboy::rom::view<B, W>, count> views,
-                        std::string_view section = "UNNAMED") {
+template <typename B, typename W, typename K, std::size_t count>
+static std::string dump(
+    const std::array<gameboy::rom::view<B, W, K>, count> views,
+    std::string_view section = "UNNAMED") {
   std::ostringstream os{};
 
-  auto hull{gameboy::rom::view<B, W>::hull(views)};
+  auto hull{gameboy::rom::view<B, W, K>::hull(views)};
 
   os << "\nSECTION \"" << section << " 0x" << std::hex
      << hull.startPtr().linear() << "\", ";
@@ -210,8 +218,8 @@ static std::string dump(const std::array<gameboy::rom::view<B, W>, count> views,
   return os.str();
 }
 
-template <typename B, typename W>
-static std::string dump(const gameboy::rom::header<B, W> header) {
+template <typename B, typename W, typename K>
+static std::string dump(const gameboy::rom::header<B, W, K> header) {
   std::ostringstream os{};
 
   if (!bool(header)) {
@@ -241,9 +249,10 @@ static std::string dump(const gameboy::rom::lazy<view, B, W, bankSize_> &lazy) {
   return os.str();
 }
 
-template <typename B, typename W>
-static std::string dump(const gameboy::rom::view<B, W> &view,
-                        const std::set<gameboy::rom::view<B, W> *> &subviews) {
+template <typename B, typename W, typename K>
+static std::string dump(
+    const gameboy::rom::view<B, W, K> &view,
+    const std::set<gameboy::rom::view<B, W, K> *> &subviews) {
   std::ostringstream os{};
 
   os << "SUBVIEWS\n"
@@ -0,0 +1,205 @@
+/* Charmap detection
+ *
+ * Guesses which of the known languages a ROM's text is in, so its strings can
+ * be decoded with the right charmap without being told. Every language looks
+ * at the same sample of the ROM, a few blocks out of every bank, and counts
+ * how much of it reads as text: the letters in runs that end the way strings
+ * do, and how often the language's common words turn up in those runs.
+ *
+ * Words decide, as languages that share most of a charmap read much the same
+ * amount of text out of the same bytes; letters only break ties. Short words
+ * turn up by chance in any data, so without at least one in every 16 KiB of
+ * the sample there's nothing to go by, and English is assumed, as it was
+ * before there was a choice.
+ *
+ * Banks are sampled concurrently.
+ */
+
+#if !defined(WHATCHAMAEDIT_DETECT_H)
+#define WHATCHAMAEDIT_DETECT_H
+
+#include <whatchamaedit/character-map.h>
+#include <whatchamaedit/view.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class detect {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  static constexpr std::size_t blockSize = 0x400;
+
+  /* how many bytes of the sample it takes for each word that the best
+   * language needs to have found. */
+  static constexpr std::size_t bytesPerWord = 0x4000;
+
+  /* how well a language fits the sample. */
+  struct score {
+    const text::language *language;
+    /* letters in runs that were terminated properly. */
+    std::size_t text;
+    /* common words in runs with at least a few letters. */
+    std::size_t words;
+  };
+
+  /** @constructor
+   *
+   * @rom the ROM to look at.
+   * @threads number of threads to use; 0 means one per hardware thread.
+   * @stride how many blocks there are per block in the sample; 1 looks at
+   * the whole ROM, and the default of 8 at an eighth of it, which is plenty
+   * for the amount of text in a typical game.
+   */
+  detect(const view &rom, std::size_t threads = 0,
+         const std::size_t stride = 8) {
+    const auto data = rom.raw();
+    const std::size_t bankSize = pointer::bankSize();
+    const std::size_t banks = (data.size() + bankSize - 1) / bankSize;
+    const auto &all = text::languages::all;
+
+    const std::size_t step = blockSize * std::max<std::size_t>(stride, 1);
+    std::vector<score> perBank(banks * all.size());
+
+    /* words are looked for in the ROM's bytes, rather than in decoded text,
+     * so nothing needs to be decoded. */
+    std::vector<needles> words(all.size());
+    for (std::size_t l = 0; l < all.size(); l++) {
+      const text::encoder encoder{all[l]->map()};
+
+      for (const auto w : all[l]->words()) {
+        if (const auto e = encoder.encode(w); e && !e->empty()) {
+          words[l].words.emplace_back(e->begin(), e->end());
+          words[l].first[e->front()] = true;
+        }
+      }
+    }
+
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::atomic<std::size_t> next{0};
+    const auto work = [&]() {
+      for (std::size_t bank; (bank = next++) < banks;) {
+        const std::size_t end = std::min((bank + 1) * bankSize, data.size());
+
+        for (std::size_t l = 0; l < all.size(); l++) {
+          score &s = perBank[bank * all.size() + l];
+          s.language = all[l];
+
+          for (std::size_t b = bank * bankSize; b < end; b += step) {
+            measure(*all[l], words[l],
+                    data.substr(b, std::min(blockSize, end - b)), s);
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> pool{};
+    for (std::size_t t = 1; t < std::min(threads, banks); t++) {
+      pool.emplace_back(work);
+    }
+
+    work();
+
+    for (auto &t : pool) {
+      t.join();
+    }
+
+    for (std::size_t b = 0; b < data.size(); b += step) {
+      sampled_ += std::min(blockSize, data.size() - b);
+    }
+
+    for (std::size_t l = 0; l < all.size(); l++) {
+      scores_.push_back({all[l], 0, 0});
+
+      for (std::size_t bank = 0; bank < banks; bank++) {
+        scores_.back().text += perBank[bank * all.size() + l].text;
+        scores_.back().words += perBank[bank * all.size() + l].words;
+      }
+    }
+  }
+
+  /* every known language's score, in the order of text::languages::all. */
+  const std::vector<score> &scores(void) const { return scores_; }
+
+  /* how many bytes the sample had. */
+  std::size_t sampled(void) const { return sampled_; }
+
+  /* the language that fits best. */
+  const text::language &best(void) const {
+    const score *rv = &scores_.front();
+
+    for (const auto &s : scores_) {
+      if (s.words > rv->words || (s.words == rv->words && s.text > rv->text)) {
+        rv = &s;
+      }
+    }
+
+    return rv->words > 0 && rv->words >= sampled_ / bytesPerWord
+               ? *rv->language
+               : text::languages::english;
+  }
+
+ protected:
+  std::vector<score> scores_{};
+  std::size_t sampled_{0};
+
+  using bytes = std::basic_string<B>;
+
+  /* a language's words, encoded, and which bytes any of them start with. */
+  struct needles {
+    std::vector<bytes> words;
+    std::array<bool, 256> first{};
+  };
+
+  /* add what @l reads out of @block to @s. */
+  static void measure(const text::language &l, const needles &words,
+                      const std::basic_string_view<B> block, score &s) {
+    std::size_t start = 0, letters = 0;
+
+    for (std::size_t i = 0; i < block.size(); i++) {
+      const uint8_t b = block[i];
+
+      if (!l.ends(b)) {
+        letters += l.text(b);
+        continue;
+      }
+
+      if (letters >= 4) {
+        if (b == l.end()) {
+          s.text += letters;
+        }
+
+        const auto run = block.substr(start, i - start);
+
+        for (std::size_t j = 0; j < run.size(); j++) {
+          if (!words.first[uint8_t(run[j])]) {
+            continue;
+          }
+
+          for (const auto &w : words.words) {
+            s.words += run.compare(j, w.size(), w) == 0;
+          }
+        }
+      }
+
+      start = i + 1;
+      letters = 0;
+    }
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,215 @@
+/* Text discovery
+ *
+ * Finds the text in a Gen I ROM by following the game's own text scripts,
+ * instead of guessing at text like string::scan() does. Starting from known
+ * text entry points or text pointer tables, each script is interpreted like
+ * the game's text engine would: text commands are decoded, far text is
+ * followed to wherever it lives, and the extent of every run of text is
+ * recorded. Only bytes that are reachable from the starting points are ever
+ * looked at.
+ *
+ * Command numbers follow macros/scripts/text.asm in the pokered disassembly.
+ */
+
+#if !defined(WHATCHAMAEDIT_DISCOVER_H)
+#define WHATCHAMAEDIT_DISCOVER_H
+
+#include <whatchamaedit/character-map.h>
+#include <whatchamaedit/view.h>
+
+#include <deque>
+#include <iterator>
+#include <set>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class discover {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+  using lazy = typename view::lazy;
+
+  /* a run of text, from its first character to its terminator. */
+  struct extent {
+    pointer start;
+    pointer end;
+
+    bool operator<(const extent &b) const { return start < b.start; }
+  };
+
+  enum command : uint8_t {
+    tx_start = 0x00,
+    tx_ram = 0x01,
+    tx_bcd = 0x02,
+    tx_move = 0x03,
+    tx_box = 0x04,
+    tx_low = 0x05,
+    tx_prompt_button = 0x06,
+    tx_scroll = 0x07,
+    tx_start_asm = 0x08,
+    tx_num = 0x09,
+    tx_pause = 0x0a,
+    tx_dots = 0x0c,
+    tx_wait_button = 0x0d,
+    tx_far = 0x17,
+    tx_end = 0x50,
+  };
+
+  discover(const view rom) : rom_{rom}, visited_(rom.dataSize(), false) {}
+
+  /* add a text pointer table.
+   *
+   * @at the start of the table.
+   * @count the number of little endian pointers in the table.
+   *
+   * The pointers are taken to point into the bank the table is in, or into
+   * bank 0 if they are below the switchable bank window.
+   */
+  void table(const pointer at, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+      const pointer p = at + i * 2;
+
+      if (!readable(p, 2)) {
+        break;
+      }
+
+      mark(p, 2);
+      entry(near(at, rom_.word_le(p)));
+    }
+  }
+
+  /* add a single text script. */
+  void entry(const pointer p) {
+    if (readable(p, 1) && entries_.insert(p).second) {
+      queue_.push_back(p);
+    }
+  }
+
+  /* follow every script that has been added so far.
+   *
+   * Scripts found along the way, i.e. far text, are followed as well. Returns
+   * the number of text runs found.
+   */
+  std::size_t run(void) {
+    while (!queue_.empty()) {
+      const pointer p = queue_.front();
+      queue_.pop_front();
+
+      script(p);
+    }
+
+    return extents_.size();
+  }
+
+  const std::set<pointer> &entries(void) const { return entries_; }
+
+  const std::set<extent> &extents(void) const { return extents_; }
+
+  /* whether a byte was reached while following the scripts. */
+  bool visited(const pointer p) const {
+    return p.linear() < visited_.size() && visited_[p.linear()];
+  }
+
+ protected:
+  const view rom_;
+  std::vector<bool> visited_;
+  std::deque<pointer> queue_{};
+  std::set<pointer> entries_{};
+  std::set<extent> extents_{};
+
+  bool readable(const pointer p, const std::size_t n) const {
+    return p.linear() + n <= visited_.size();
+  }
+
+  void mark(const pointer p, const std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+      visited_[p.linear() + i] = true;
+    }
+  }
+
+  /* resolve a 16 bit pointer as seen from code or data in @from's bank. */
+  static pointer near(const pointer from, const W offset) {
+    if (offset < pointer::bankSize()) {
+      return pointer{std::size_t(offset)};
+    }
+
+    return pointer{from.bank(), offset};
+  }
+
+  /* follow a single script.
+   *
+   * Stops at the end of the script, at anything we can't follow (such as
+   * embedded assembly), and at anything that was already visited, since then
+   * the rest of the script has been followed before.
+   */
+  void script(pointer p) {
+    static const std::size_t length[0x18]{
+        0, 3, 4, 3, 5, 1, 1, 1, 0, 4, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4};
+
+    while (readable(p, 1) && !visited(p)) {
+      const uint8_t c = rom_.byte(p);
+
+      if (c == tx_end) {
+        mark(p, 1);
+        return;
+      }
+
+      if (c == tx_start) {
+        mark(p, 1);
+        if (!text(p + 1, p)) {
+          return;
+        }
+        continue;
+      }
+
+      if (c >= std::size(length) || c == tx_start_asm ||
+          !readable(p, length[c])) {
+        return;
+      }
+
+      if (c == tx_far) {
+        const lazy far{rom_.from(p + 3).asROMBank(),
+                       rom_.from(p + 1).asLittleEndian().asROMOffset()};
+
+        if (!far) {
+          return;
+        }
+
+        entry(pointer(far));
+      }
+
+      mark(p, length[c]);
+      p = p + length[c];
+    }
+  }
+
+  /* follow a run of text starting at @start.
+   *
+   * Updates @next to the command after the text's terminator and returns true
+   * if the script continues after the text, false if it ended.
+   */
+  bool text(const pointer start, pointer &next) {
+    for (pointer p = start; readable(p, 1); p++) {
+      const uint8_t c = rom_.byte(p);
+
+      if (c == text::pokemon::bgry::end || c == 0x57 || c == 0x58) {
+        mark(start, p - start + 1);
+        extents_.insert({start, p});
+        next = p + 1;
+        return c == text::pokemon::bgry::end;
+      }
+
+      if (c == 0 || text::pokemon::bgry::english.count(c) == 0) {
+        break;
+      }
+    }
+
+    return false;
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,237 @@
+/* Free space
+ *
+ * Finds unused space in a ROM, i.e. long runs of 0x00 or 0xff padding, and
+ * hands it out to anything that needs to place new data, like relocated text.
+ *
+ * Runs are found with vector compares where SSE2 is available, 16 bytes at a
+ * time, and with a plain loop everywhere else. The free space is kept as a set
+ * of disjoint intervals, ordered by address, which never cross a bank
+ * boundary since nothing in a ROM can be split across banks.
+ */
+
+#if !defined(WHATCHAMAEDIT_FREE_SPACE_H)
+#define WHATCHAMAEDIT_FREE_SPACE_H
+
+#include <whatchamaedit/view.h>
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class freespace {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  /* free regions, as a map from start to one past the end, in linear
+   * addresses. */
+  using regions = std::map<std::size_t, std::size_t>;
+
+  /** @constructor
+   *
+   * @rom the ROM to look for free space in.
+   * @minimum the shortest run of padding that counts as free space.
+   * @trailing only count runs that go all the way to the end of their bank;
+   * runs in the middle of a bank are much more likely to be data that just
+   * happens to be all zeroes.
+   *
+   * The first byte of every run that doesn't start its bank is left alone, as
+   * it may well be the last byte of whatever comes before it.
+   */
+  freespace(const view &rom, const std::size_t minimum = 64,
+            const bool trailing = true) {
+    const auto data = rom.raw();
+    const std::size_t bankSize = pointer::bankSize();
+
+    for (std::size_t bank = 0; bank * bankSize < data.size(); bank++) {
+      const std::size_t start = bank * bankSize;
+      const std::size_t end = std::min(start + bankSize, data.size());
+
+      for (std::size_t i = next(data, start, end); i < end;) {
+        const std::size_t j = run(data, i, end);
+        const std::size_t s = i == start ? i : i + 1;
+
+        if (j - s >= minimum && (!trailing || j == end)) {
+          regions_.emplace(s, j);
+        }
+
+        i = next(data, j, end);
+      }
+    }
+  }
+
+  /* allocate space.
+   *
+   * @size the number of bytes needed.
+   * @bank the bank the space needs to be in, if any.
+   * @alignment what the start of the space needs to be a multiple of.
+   *
+   * Picks the smallest free region that fits, so that large regions remain
+   * available for large allocations, and removes the space from the map.
+   * Returns nothing if there's no suitable space left.
+   */
+  std::optional<pointer> allocate(const std::size_t size,
+                                  const std::optional<std::size_t> bank = {},
+                                  const std::size_t alignment = 1) {
+    const std::size_t bankSize = pointer::bankSize();
+    auto it = bank ? regions_.lower_bound(*bank * bankSize) : regions_.begin();
+    const auto end =
+        bank ? regions_.lower_bound((*bank + 1) * bankSize) : regions_.end();
+
+    auto best = regions_.end();
+    std::size_t bestStart = 0;
+
+    for (; it != end; it++) {
+      const std::size_t a = align(it->first, alignment);
+
+      if (a + size <= it->second &&
+          (best == regions_.end() ||
+           it->second - it->first < best->second - best->first)) {
+        best = it;
+        bestStart = a;
+      }
+    }
+
+    if (best == regions_.end() || size == 0) {
+      return {};
+    }
+
+    const auto [s, e] = *best;
+    regions_.erase(best);
+
+    if (s < bestStart) {
+      regions_.emplace(s, bestStart);
+    }
+    if (bestStart + size < e) {
+      regions_.emplace(bestStart + size, e);
+    }
+
+    return pointer{bestStart};
+  }
+
+  /* give space back, e.g. where text used to be before it was moved.
+   *
+   * Merges the space with adjacent free regions in the same bank.
+   */
+  void release(const pointer p, const std::size_t size) {
+    const std::size_t bankSize = pointer::bankSize();
+    std::size_t s = p.linear();
+    std::size_t e = s + size;
+
+    if (size == 0 || e > (s / bankSize + 1) * bankSize) {
+      return;
+    }
+
+    auto it = regions_.lower_bound(s);
+
+    if (it != regions_.begin()) {
+      const auto prev = std::prev(it);
+      if (prev->second >= s && (prev->first / bankSize) == s / bankSize) {
+        s = prev->first;
+        e = std::max(e, prev->second);
+        regions_.erase(prev);
+      }
+    }
+
+    while (it != regions_.end() && it->first <= e &&
+           it->first / bankSize == s / bankSize) {
+      e = std::max(e, it->second);
+      it = regions_.erase(it);
+    }
+
+    regions_.emplace(s, e);
+  }
+
+  /* total free space, in bytes, optionally only in one bank. */
+  std::size_t available(const std::optional<std::size_t> bank = {}) const {
+    const std::size_t bankSize = pointer::bankSize();
+    auto it = bank ? regions_.lower_bound(*bank * bankSize) : regions_.begin();
+    const auto end =
+        bank ? regions_.lower_bound((*bank + 1) * bankSize) : regions_.end();
+    std::size_t rv = 0;
+
+    for (; it != end; it++) {
+      rv += it->second - it->first;
+    }
+
+    return rv;
+  }
+
+  const regions &free(void) const { return regions_; }
+
+ protected:
+  regions regions_{};
+
+  static constexpr std::size_t align(const std::size_t p,
+                                     const std::size_t alignment) {
+    return alignment > 1 ? (p + alignment - 1) / alignment * alignment : p;
+  }
+
+  /* find the first byte at or after @i that could start a run. */
+  static std::size_t next(const std::basic_string_view<B> data, std::size_t i,
+                          const std::size_t end) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(char(0xff));
+
+    for (; i + 16 <= end; i += 16) {
+      const __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + i));
+      const int m = _mm_movemask_epi8(
+          _mm_or_si128(_mm_cmpeq_epi8(v, zero), _mm_cmpeq_epi8(v, ones)));
+
+      if (m != 0) {
+        return i + __builtin_ctz(m);
+      }
+    }
+#endif
+
+    for (; i < end; i++) {
+      const uint8_t b = data[i];
+      if (b == 0x00 || b == 0xff) {
+        break;
+      }
+    }
+
+    return i;
+  }
+
+  /* find the end of the run of identical bytes that starts at @i. */
+  static std::size_t run(const std::basic_string_view<B> data, std::size_t i,
+                         const std::size_t end) {
+    const B value = data[i];
+
+#if defined(__SSE2__)
+    const __m128i v = _mm_set1_epi8(char(value));
+
+    for (; i + 16 <= end; i += 16) {
+      const __m128i d =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + i));
+      const int m = _mm_movemask_epi8(_mm_cmpeq_epi8(d, v));
+
+      if (m != 0xffff) {
+        return i + __builtin_ctz(~m);
+      }
+    }
+#endif
+
+    while (i < end && data[i] == value) {
+      i++;
+    }
+
+    return i;
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
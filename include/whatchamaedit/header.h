@@ -2,6 +2,7 @@
 #define WHATCHAMAEDIT_HEADER_H
 
 #include <string.h>
+#include <whatchamaedit/layout.h>
 #include <whatchamaedit/view.h>
 
 #include <functional>
@@ -9,10 +10,10 @@
 
 namespace gameboy {
 namespace rom {
-template <typename B = uint8_t, typename W = uint16_t>
-class header : public view<B, W> {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class header : public view<B, W, K> {
  public:
-  using view = view<B, W>;
+  using view = view<B, W, K>;
   using pointer = typename view::pointer;
 
  protected:
@@ -20,6 +21,54 @@ class header : public view<B, W> {
   static constexpr pointer end{0x014f};
 
  public:
+  /* where each field is in format, below; with these, fields can also be read
+   * straight from the ROM's bytes, e.g. format.byte(data, f_rom). */
+  enum slot : std::size_t {
+    f_entry,
+    f_logo,
+    f_title,
+    f_manufacturer,
+    f_gbcolor,
+    f_licensee,
+    f_supergb,
+    f_cartridge,
+    f_rom,
+    f_ram,
+    f_region,
+    f_oldLicensee,
+    f_version,
+    f_headerChecksum,
+    f_globalChecksum,
+  };
+
+  /* the header's fields; the manufacturer code and colour flags were carved
+   * out of the end of the title later, so they overlay it. */
+  static constexpr gameboy::layout format{
+      0x0100,
+      field{"__gb_entry_point", dt_code, 4},
+      field{"__gb_nintendo_logo", dt_bytes, 0x30},
+      field{"__gb_cartridge_title", dt_text, 0x10},
+      field{"__gb_manufacturer_code", dt_text, 4}.at(0x013f),
+      field{"__gb_color_flags", dt_byte, 1}.at(0x0143),
+      field{"__gb_licensee_code", dt_text, 2},
+      field{"__gb_super_flags", dt_byte, 1},
+      field{"__gb_cartridge_flags", dt_byte, 1},
+      field{"__gb_rom_size_flags", dt_byte, 1},
+      field{"__gb_ram_size_flags", dt_byte, 1},
+      field{"__gb_region_code", dt_byte, 1},
+      field{"__gb_old_licensee_code", dt_byte, 1},
+      field{"__gb_cartridge_version", dt_byte, 1},
+      field{"__gb_header_chksum", dt_byte, 1},
+      field{"__gb_global_chksum", dt_word, 2}.asBigEndian(),
+  };
+
+  static_assert(format.disjoint(), "header fields overlap");
+  static_assert(format.start() == start.linear() &&
+                    format.end() == end.linear() + 1,
+                "header fields don't cover the header");
+  static_assert(format[f_globalChecksum].name == "__gb_global_chksum",
+                "header slots don't match its format");
+
   /** @constructor
    *
    * @v a view over the whole ROM for which to initialise this ROM header from.
@@ -30,37 +79,26 @@ class header : public view<B, W> {
    * counter-intuitive but this feels like the best place to put the checksum
    * calculations.
    *
-   * All other fields are initialised with a view recipe for mapping ROM header
-   * locations to their fields, and can therefore be read directly.
+   * All other fields are views at the constant offsets in format, and can
+   * therefore be read directly.
    */
   constexpr header(view v)
       : view{v.asLittleEndian()},
-        entry{view::from(start).length(0x0004).expect(dt_code).label(
-            "__gb_entry_point")},
-        logo{view::after(entry).to(0x0133).is(dt_bytes).label(
-            "__gb_nintendo_logo")},
-        title{view::after(logo).to(0x0143).is(dt_text).label(
-            "__gb_cartridge_title")},
-        manufacturer{view::from(0x013f).to(0x0142).is(dt_text).label(
-            "__gb_manufacturer_code")},
-        gbcolor{view::from(0x0143).asByte().label("__gb_color_flags")},
-        licensee{view::after(title).is(dt_text).length(0x0002).label(
-            "__gb_licensee_code")},
-        supergb{view::after(licensee).asByte().label("__gb_super_flags")},
-        cartridge{view::after(supergb).asByte().label("__gb_cartridge_flags")},
-        rom{view::after(cartridge).asByte().label("__gb_rom_size_flags")},
-        ram{view::after(rom).asByte().label("__gb_ram_size_flags")},
-        region{view::after(ram).asByte().label("__gb_region_code")},
-        oldLicensee{
-            view::after(region).asByte().label("__gb_old_licensee_code")},
-        version{
-            view::after(oldLicensee).asByte().label("__gb_cartridge_version")},
-        headerChecksum_{
-            view::after(version).asByte().label("__gb_header_chksum")},
-        globalChecksum_{view::after(headerChecksum_)
-                            .asWord()
-                            .asBigEndian()
-                            .label("__gb_global_chksum")} {}
+        entry{format.at(v, f_entry)},
+        logo{format.at(v, f_logo)},
+        title{format.at(v, f_title)},
+        manufacturer{format.at(v, f_manufacturer)},
+        gbcolor{format.at(v, f_gbcolor)},
+        licensee{format.at(v, f_licensee)},
+        supergb{format.at(v, f_supergb)},
+        cartridge{format.at(v, f_cartridge)},
+        rom{format.at(v, f_rom)},
+        ram{format.at(v, f_ram)},
+        region{format.at(v, f_region)},
+        oldLicensee{format.at(v, f_oldLicensee)},
+        version{format.at(v, f_version)},
+        headerChecksum_{format.at(v, f_headerChecksum)},
+        globalChecksum_{format.at(v, f_globalChecksum)} {}
 
   constexpr B checksumH(bool calculate) const {
     if (calculate) {
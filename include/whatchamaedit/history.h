@@ -0,0 +1,272 @@
+/* Undo/redo history
+ *
+ * Records changes to an image as deltas - an offset plus the bytes before and
+ * after the change - instead of as copies of the whole image. The bytes go into
+ * two arenas, one for the old and one for the new contents, and each delta only
+ * remembers where in the arenas its bytes are. The arenas are contiguous, so
+ * undo() and redo() hand out views of them rather than copies; forgotten bytes
+ * at the front are only moved out of the way once they make up half an arena.
+ *
+ * Deltas are collected into groups, which are what undo() and redo() operate
+ * on; checkpoint() closes the current group. Undoing or redoing a group only
+ * touches the bytes that group changed.
+ */
+
+#if !defined(WHATCHAMAEDIT_HISTORY_H)
+#define WHATCHAMAEDIT_HISTORY_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t>
+class history {
+ public:
+  using bytes = std::basic_string_view<B>;
+
+  /** @constructor
+   *
+   * @limit the maximum number of bytes to keep history for; if recording a
+   * change would exceed this, the oldest groups are forgotten. The group that
+   * is currently being recorded is always kept, however. A limit of 0 disables
+   * recording entirely.
+   */
+  history(const std::size_t limit = 4 << 20) : limit_{limit} {}
+
+  /* record a change.
+   *
+   * @offset where the change starts, as a linear address.
+   * @before the bytes at @offset before the change.
+   * @after the bytes at @offset after the change; must be the same length as
+   * @before.
+   *
+   * Recording a change discards anything that could have been redone. A change
+   * that starts right where the previous one in the same group ended is merged
+   * into that previous delta.
+   */
+  void record(const std::size_t offset, const bytes before, const bytes after) {
+    if (limit_ == 0 || before.empty() || before.size() != after.size()) {
+      return;
+    }
+
+    truncate();
+
+    if (!open_) {
+      groups_.push_back(base_.deltas + deltas_.size());
+      applied_++;
+      open_ = true;
+    }
+
+    if (!deltas_.empty() && first(groups_.size() - 1) < deltas_.size() &&
+        deltas_.back().offset + deltas_.back().length == offset) {
+      deltas_.back().length += before.size();
+    } else {
+      deltas_.push_back({offset, before.size(), base_.bytes + before_.size()});
+    }
+
+    before_.append(before);
+    after_.append(after);
+
+    trim();
+  }
+
+  /* close the current group.
+   *
+   * The next change that is recorded starts a new group.
+   */
+  void checkpoint(void) { open_ = false; }
+
+  /* undo the most recent group.
+   *
+   * @write called as write(offset, bytes) for every delta in the group, in
+   * reverse order, to restore the old contents; @bytes points into the
+   * history, so it must not be recorded again before write() returns.
+   *
+   * Returns false if there's nothing to undo.
+   */
+  template <typename F>
+  bool undo(F write) {
+    checkpoint();
+
+    if (applied_ == 0) {
+      return false;
+    }
+
+    applied_--;
+
+    for (std::size_t d = last(applied_); d-- > first(applied_);) {
+      write(deltas_[d].offset, get(before_, deltas_[d]));
+    }
+
+    return true;
+  }
+
+  /* redo the most recently undone group.
+   *
+   * @write called as write(offset, bytes) for every delta in the group, in
+   * recording order; as with undo(), @bytes points into the history.
+   *
+   * Returns false if there's nothing to redo.
+   */
+  template <typename F>
+  bool redo(F write) {
+    checkpoint();
+
+    if (applied_ == groups_.size()) {
+      return false;
+    }
+
+    for (std::size_t d = first(applied_); d < last(applied_); d++) {
+      write(deltas_[d].offset, get(after_, deltas_[d]));
+    }
+
+    applied_++;
+
+    return true;
+  }
+
+  bool canUndo(void) const { return applied_ > 0; }
+
+  bool canRedo(void) const { return applied_ < groups_.size(); }
+
+  /* change the history size limit.
+   *
+   * Takes effect immediately; see the constructor for details.
+   */
+  void limit(const std::size_t l) {
+    limit_ = l;
+
+    if (limit_ == 0) {
+      clear();
+    } else {
+      trim();
+    }
+  }
+
+  std::size_t limit(void) const { return limit_; }
+
+  /* approximate number of bytes used by the history. */
+  std::size_t size(void) const {
+    return (before_.size() - dead_) * 2 + deltas_.size() * sizeof(delta) +
+           groups_.size() * sizeof(std::size_t);
+  }
+
+  void clear(void) {
+    base_.deltas += deltas_.size();
+    base_.bytes += before_.size();
+    dead_ = 0;
+
+    deltas_.clear();
+    groups_.clear();
+    before_.clear();
+    after_.clear();
+
+    applied_ = 0;
+    open_ = false;
+  }
+
+ protected:
+  struct delta {
+    std::size_t offset;
+    std::size_t length;
+    std::size_t position;
+  };
+
+  /* the history only ever loses elements at the front when trimming, so we
+   * keep track of how many there were to keep the absolute indices in groups_
+   * and delta::position valid. */
+  struct {
+    std::size_t deltas = 0;
+    std::size_t bytes = 0;
+  } base_;
+
+  std::deque<delta> deltas_{};
+  std::deque<std::size_t> groups_{};
+  std::basic_string<B> before_{};
+  std::basic_string<B> after_{};
+
+  /* bytes at the front of the arenas that belong to forgotten groups. */
+  std::size_t dead_ = 0;
+
+  std::size_t applied_ = 0;
+  bool open_ = false;
+  std::size_t limit_;
+
+  std::size_t first(const std::size_t group) const {
+    return groups_[group] - base_.deltas;
+  }
+
+  std::size_t last(const std::size_t group) const {
+    return group + 1 < groups_.size() ? first(group + 1) : deltas_.size();
+  }
+
+  bytes get(const std::basic_string<B> &arena, const delta &d) const {
+    return bytes{arena}.substr(d.position - base_.bytes, d.length);
+  }
+
+  /* where the bytes of delta @d start in the arenas, or their end if @d is
+   * one past the last delta. */
+  std::size_t position(const std::size_t d) const {
+    return d < deltas_.size() ? deltas_[d].position - base_.bytes
+                              : before_.size();
+  }
+
+  /* forget everything that could be redone. */
+  void truncate(void) {
+    if (applied_ == groups_.size()) {
+      return;
+    }
+
+    drop(applied_);
+  }
+
+  /* forget group @g and all the groups after it. */
+  void drop(const std::size_t g) {
+    const std::size_t d = first(g);
+    const std::size_t b = position(d);
+
+    deltas_.erase(deltas_.begin() + d, deltas_.end());
+    groups_.erase(groups_.begin() + g, groups_.end());
+    before_.resize(b);
+    after_.resize(b);
+
+    open_ = false;
+  }
+
+  /* forget groups until we're within the limit again: the ones that could be
+   * redone first, newest first, as they're the least likely to be needed, and
+   * then the oldest ones that were applied. */
+  void trim(void) {
+    while (size() > limit_ && groups_.size() > 1) {
+      if (applied_ < groups_.size()) {
+        drop(groups_.size() - 1);
+        continue;
+      }
+
+      const std::size_t d = last(0);
+      const std::size_t b = position(d);
+
+      deltas_.erase(deltas_.begin(), deltas_.begin() + d);
+      groups_.pop_front();
+
+      base_.deltas += d;
+      dead_ = b;
+      applied_--;
+
+      /* move the live bytes to the front only once that's worth it, so
+       * trimming stays linear in the number of bytes recorded. */
+      if (dead_ > before_.size() / 2) {
+        before_.erase(0, dead_);
+        after_.erase(0, dead_);
+        base_.bytes += dead_;
+        dead_ = 0;
+      }
+    }
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -1,8 +1,13 @@
 #if !defined(WHATCHAMAEDIT_IMAGE_H)
 #define WHATCHAMAEDIT_IMAGE_H
 
+#include <whatchamaedit/history.h>
 #include <whatchamaedit/view.h>
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 namespace gameboy {
 namespace rom {
 template <std::size_t count, typename B = uint8_t, typename W = uint16_t>
@@ -12,11 +17,15 @@ class blank : public gameboy::rom::generic::blank<count, B, W> {
   constexpr bool save(const std::string &) const { return false; }
 };
 
-template <typename B = uint8_t, typename W = uint16_t>
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
 class image {
  public:
-  using pointer = gameboy::rom::pointer<B, W>;
-  using view = gameboy::rom::view<B, W>;
+  using pointer = gameboy::rom::pointer<K, W>;
+  using view = gameboy::rom::view<B, W, K>;
+
+  /* told about every change to an image: where it starts, as a linear
+   * address, and how many bytes it covers. */
+  using listener = std::function<void(std::size_t, std::size_t)>;
 
   image(const std::string &file) : data_{}, loadOK(load(file)) {}
 
@@ -40,6 +49,78 @@ class image {
 
   constexpr operator bool(void) const { return loadOK; }
 
+  /* write raw bytes into the image.
+   *
+   * @p where to start writing.
+   * @bytes what to write there.
+   *
+   * The whole range is checked once up front; nothing is written unless all of
+   * @bytes fit into the image. Writes are recorded in the image's history.
+   */
+  bool write(const pointer p, const std::basic_string_view<B> bytes) {
+    const std::size_t start = p.linear();
+
+    if (start > data_.size() || bytes.size() > data_.size() - start) {
+      return false;
+    }
+
+    history_.record(start, {data_.data() + start, bytes.size()}, bytes);
+
+    change(start, bytes);
+
+    return true;
+  }
+
+  /* undo the most recent group of writes.
+   *
+   * Returns false if there was nothing to undo.
+   */
+  bool undo(void) {
+    return history_.undo([this](std::size_t o, std::basic_string_view<B> b) {
+      change(o, b);
+    });
+  }
+
+  /* redo the most recently undone group of writes.
+   *
+   * Returns false if there was nothing to redo.
+   */
+  bool redo(void) {
+    return history_.redo([this](std::size_t o, std::basic_string_view<B> b) {
+      change(o, b);
+    });
+  }
+
+  /* end the current group of writes, so they're undone in one go. */
+  void checkpoint(void) { history_.checkpoint(); }
+
+  gameboy::rom::history<B> &history(void) { return history_; }
+
+  /* number of changes made to the image so far.
+   *
+   * Anything derived from the image's contents can remember this to tell if
+   * it needs to be derived again.
+   */
+  std::size_t revision(void) const { return revision_; }
+
+  /* have @l called after every change to the image, including undo and redo.
+   *
+   * This is for caches and indices that can bring themselves up to date by
+   * only looking at what changed, rather than rebuilding everything when the
+   * revision changes. Returns a handle for unsubscribe().
+   */
+  std::size_t subscribe(listener l) {
+    listeners_.push_back({++subscriptions_, l});
+    return subscriptions_;
+  }
+
+  void unsubscribe(const std::size_t handle) {
+    listeners_.erase(
+        std::remove_if(listeners_.begin(), listeners_.end(),
+                       [handle](const auto &l) { return l.first == handle; }),
+        listeners_.end());
+  }
+
   constexpr std::basic_string_view<B> readonly(void) const {
     return {data_.data(), data_.size()};
   }
@@ -51,6 +132,20 @@ class image {
  protected:
   std::vector<B> data_;
   bool loadOK;
+  gameboy::rom::history<B> history_{};
+  std::size_t revision_{0};
+  std::vector<std::pair<std::size_t, listener>> listeners_{};
+  std::size_t subscriptions_{0};
+
+  /* the only place the image's contents change. */
+  void change(const std::size_t offset, const std::basic_string_view<B> b) {
+    std::copy(b.begin(), b.end(), data_.begin() + offset);
+    revision_++;
+
+    for (const auto &l : listeners_) {
+      l.second(offset, b.size());
+    }
+  }
 };
 }  // namespace rom
 }  // namespace gameboy
@@ -0,0 +1,183 @@
+/* Structure layouts
+ *
+ * Fixed structures, like the cartridge header, are declared as a list of
+ * fields that is turned into a table of offsets at compile time, so decoding
+ * one is a matter of reading at constant offsets rather than building a chain
+ * of views that each start after the previous one:
+ *
+ *     static constexpr gameboy::layout example{
+ *         0x0100,
+ *         gameboy::field{"entry", gameboy::dt_code, 4},
+ *         gameboy::field{"checksum", gameboy::dt_word, 2}.asBigEndian(),
+ *         gameboy::field{"opcode", gameboy::dt_byte, 1}.at(0x0100),
+ *     };
+ *     static_assert(example.disjoint());
+ *
+ * Fields follow each other, starting at the layout's start address, unless
+ * they are given an address with at(). Those are overlays, e.g. a flags byte
+ * that's also the last character of a string, and need to be inside one of the
+ * other fields; all other fields must not overlap each other.
+ */
+
+#if !defined(WHATCHAMAEDIT_LAYOUT_H)
+#define WHATCHAMAEDIT_LAYOUT_H
+
+#include <whatchamaedit/view.h>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace gameboy {
+class field {
+ public:
+  constexpr field(const std::string_view name, const gameboy::type type,
+                  const std::size_t length)
+      : name{name}, type{type}, length{length} {}
+
+  /* make this an overlay at @address. */
+  constexpr field at(const std::size_t address) const {
+    field f = *this;
+    f.address = address;
+    f.overlay = true;
+    return f;
+  }
+
+  constexpr field asLittleEndian(void) const {
+    field f = *this;
+    f.endianness = e_little_endian;
+    return f;
+  }
+
+  constexpr field asBigEndian(void) const {
+    field f = *this;
+    f.endianness = e_big_endian;
+    return f;
+  }
+
+  /* one past the last byte of the field. */
+  constexpr std::size_t end(void) const { return address + length; }
+
+  std::string_view name;
+  gameboy::type type;
+  std::size_t length;
+  gameboy::endianness endianness{e_little_endian};
+  std::size_t address{0};
+  bool overlay{false};
+};
+
+template <std::size_t N>
+class layout {
+ public:
+  template <typename... F>
+  constexpr layout(const std::size_t start, const F... fields)
+      : start_{start}, end_{start}, fields_{fields...} {
+    for (auto &f : fields_) {
+      if (!f.overlay) {
+        f.address = end_;
+        end_ += f.length;
+      }
+    }
+  }
+
+  constexpr std::size_t size(void) const { return N; }
+
+  /* where the first field starts. */
+  constexpr std::size_t start(void) const { return start_; }
+
+  /* one past the end of the last field that isn't an overlay. */
+  constexpr std::size_t end(void) const { return end_; }
+
+  constexpr const field &operator[](const std::size_t i) const {
+    return fields_[i];
+  }
+
+  /* the index of the field called @name, or size() if there isn't one. */
+  constexpr std::size_t index(const std::string_view name) const {
+    for (std::size_t i = 0; i < N; i++) {
+      if (fields_[i].name == name) {
+        return i;
+      }
+    }
+
+    return N;
+  }
+
+  /* whether fields only overlap where they're meant to.
+   *
+   * This is meant for static_assert()s next to the layout's declaration.
+   */
+  constexpr bool disjoint(void) const {
+    for (std::size_t i = 0; i < N; i++) {
+      const auto &a = fields_[i];
+      bool inside = !a.overlay;
+
+      for (std::size_t j = 0; j < N; j++) {
+        const auto &b = fields_[j];
+
+        if (i == j || b.overlay) {
+          continue;
+        }
+
+        if (a.overlay) {
+          inside = inside || (b.address <= a.address && a.end() <= b.end());
+        } else if (a.address < b.end() && b.address < a.end()) {
+          return false;
+        }
+      }
+
+      if (!inside) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /* field @i of the structure in @v, as an annotated view.
+   *
+   * @v a view that starts where addresses in the layout are relative to;
+   * for the cartridge header, that's the start of the ROM.
+   */
+  template <typename view>
+  constexpr view at(const view &v, const std::size_t i) const {
+    const auto &f = fields_[i];
+    typename view::annotations a{f.type};
+    a.endianness = f.endianness;
+    a.label = f.name;
+
+    return v.from(v.startPtr() + f.address).length(f.length).expect(a);
+  }
+
+  /* the value of byte field @i in @data, which needs to be at least end()
+   * bytes long and start where addresses in the layout are relative to; no
+   * bounds checking. */
+  template <typename B>
+  constexpr uint8_t byte(const std::basic_string_view<B> data,
+                         const std::size_t i) const {
+    return data[fields_[i].address];
+  }
+
+  /* the value of word field @i in @data, in the field's endianness; no
+   * bounds checking. */
+  template <typename B>
+  constexpr uint16_t word(const std::basic_string_view<B> data,
+                          const std::size_t i) const {
+    const std::size_t a = fields_[i].address;
+    const uint8_t lo = data[a], hi = data[a + 1];
+
+    return fields_[i].endianness == e_big_endian ? lo << 8 | hi
+                                                 : hi << 8 | lo;
+  }
+
+ protected:
+  std::size_t start_;
+  std::size_t end_;
+  std::array<field, N> fields_;
+};
+
+template <typename... F>
+layout(std::size_t, F...) -> layout<sizeof...(F)>;
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,131 @@
+/* Push-based pipelines
+ *
+ * A source pushes items, one at a time, into whatever it's connected to, and
+ * stages can be put in between to drop or change items:
+ *
+ *     using namespace gameboy::pipeline;
+ *
+ *     rom.strings() | filter(inBank) | rom.decode() | filter(longEnough) |
+ *         each(print);
+ *
+ * Every item makes it all the way through before the next one is looked at,
+ * and nothing is collected along the way, so memory use doesn't depend on how
+ * many items there are and the first one comes out as soon as it's found.
+ *
+ * Sources and stages can be combined into larger sources and stages, and only
+ * connecting a source to a sink, made with each(), runs it.
+ */
+
+#if !defined(WHATCHAMAEDIT_PIPELINE_H)
+#define WHATCHAMAEDIT_PIPELINE_H
+
+namespace gameboy {
+namespace pipeline {
+/* something that produces items.
+ *
+ * @F called with a sink, which it calls with every item, in order.
+ */
+template <typename F>
+class source {
+ public:
+  constexpr source(F run) : run_{run} {}
+
+  template <typename S>
+  void operator()(const S &sink) const {
+    run_(sink);
+  }
+
+ protected:
+  F run_;
+};
+
+/* something between a source and a sink.
+ *
+ * @F called with the sink a stage is connected to, and returns the sink that
+ * the stage's source should push items into instead.
+ */
+template <typename F>
+class stage {
+ public:
+  constexpr stage(F wrap) : wrap_{wrap} {}
+
+  template <typename S>
+  auto operator()(const S &sink) const {
+    return wrap_(sink);
+  }
+
+ protected:
+  F wrap_;
+};
+
+/* the end of a pipeline. */
+template <typename F>
+class sink {
+ public:
+  constexpr sink(F f) : f_{f} {}
+
+  template <typename T>
+  void operator()(const T &item) const {
+    f_(item);
+  }
+
+ protected:
+  F f_;
+};
+
+/* a source for the items in @c, which is copied, so it should be cheap to
+ * copy, like a view. */
+template <typename C>
+constexpr auto from(const C c) {
+  return source{[c](const auto &sink) {
+    for (const auto &item : c) {
+      sink(item);
+    }
+  }};
+}
+
+/* only pass on items that @keep returns true for. */
+template <typename P>
+constexpr auto filter(const P keep) {
+  return stage{[keep](const auto &sink) {
+    return [keep, sink](const auto &item) {
+      if (keep(item)) {
+        sink(item);
+      }
+    };
+  }};
+}
+
+/* pass on @f(item) instead of each item. */
+template <typename F>
+constexpr auto transform(const F f) {
+  return stage{[f](const auto &sink) {
+    return [f, sink](const auto &item) { sink(f(item)); };
+  }};
+}
+
+/* call @f with every item that reaches the end of the pipeline. */
+template <typename F>
+constexpr auto each(const F f) {
+  return sink<F>{f};
+}
+
+template <typename A, typename B>
+constexpr auto operator|(const source<A> &s, const stage<B> &t) {
+  return source{[s, t](const auto &sink) { s(t(sink)); }};
+}
+
+template <typename A, typename B>
+constexpr auto operator|(const stage<A> &a, const stage<B> &b) {
+  return stage{[a, b](const auto &sink) { return a(b(sink)); }};
+}
+
+/* run the pipeline. */
+template <typename A, typename B>
+void operator|(const source<A> &s, const sink<B> &k) {
+  s(k);
+}
+}  // namespace pipeline
+}  // namespace gameboy
+
+#endif
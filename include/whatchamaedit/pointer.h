@@ -1,16 +1,29 @@
 #if !defined(WHATCHAMAEDIT_POINTER_H)
 #define WHATCHAMAEDIT_POINTER_H
 
+#include <cstdint>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 namespace gameboy {
 namespace rom {
+/* an address in a ROM.
+ *
+ * Pointers are kept as a linear address, plus whether they were given as a
+ * bank and offset, which is all that's needed to get either back. That keeps
+ * them at 8 bytes, which matters as views hold three of them and views are
+ * copied all over the place. No ROM comes anywhere near 4 GiB.
+ */
 template <typename B = int8_t, typename W = int16_t, W bankSize_ = 0x4000>
 class pointer {
  public:
   constexpr pointer(B bank, W offset)
-      : bank_(bank), offset_(normaliseOffset(bank, offset)) {}
-  constexpr pointer(size_t linear) : linear_(linear) {}
+      : linear_(uint32_t(bank * std::size_t(bankSize_) +
+                         normaliseOffset(0, offset))),
+        banked_(true) {}
+  constexpr pointer(size_t linear)
+      : linear_(uint32_t(linear)), banked_(false) {}
 
   /* copy a pointer, enforce a linear address reference.
    *
@@ -44,30 +57,79 @@ class pointer {
     return isLinear() ? asLinear(ptr) : asBanked(ptr);
   }
 
-  constexpr bool isLinear(void) const { return bool(linear_); }
+  /* parse a pointer from its textual representation.
+   *
+   * Accepts the two notations that debug::dump() produces, both in hex with an
+   * optional 0x or $ prefix: a plain linear address, e.g. "0x01a2b3", or a
+   * bank:offset pair, e.g. "1a:4f20". Returns nothing if the text isn't a
+   * pointer.
+   */
+  static std::optional<pointer> parse(std::string_view s) {
+    const auto number = [](std::string_view n) -> std::optional<size_t> {
+      if (n.rfind("0x", 0) == 0 || n.rfind("0X", 0) == 0) {
+        n.remove_prefix(2);
+      } else if (n.rfind("$", 0) == 0) {
+        n.remove_prefix(1);
+      }
+
+      if (n.empty() || n.size() > 8) {
+        return {};
+      }
+
+      size_t v = 0;
+      for (const auto c : n) {
+        if (c >= '0' && c <= '9') {
+          v = v * 16 + (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+          v = v * 16 + (c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+          v = v * 16 + (c - 'A' + 10);
+        } else {
+          return {};
+        }
+      }
+
+      return v;
+    };
+
+    if (const auto colon = s.find(':'); colon != std::string_view::npos) {
+      const auto bank = number(s.substr(0, colon));
+      const auto offset = number(s.substr(colon + 1));
+
+      if (bank && offset && *offset < size_t(bankSize_) * 2) {
+        return pointer{B(*bank), W(*offset)};
+      }
+
+      return {};
+    }
 
-  constexpr bool isBanked(void) const { return bool(bank_) && bool(offset_); }
+    if (const auto linear = number(s)) {
+      return pointer{*linear};
+    }
 
-  constexpr const B bank(void) const {
-    return bank_ ? *bank_ : banks(*linear_);
+    return {};
   }
 
+  constexpr bool isLinear(void) const { return !banked_; }
+
+  constexpr bool isBanked(void) const { return banked_; }
+
+  constexpr const B bank(void) const { return B(banks(linear_)); }
+
   constexpr const W offset(void) const {
-    return offset_ ? *offset_ : normaliseOffset(bank(), *linear_);
+    return normaliseOffset(bank(), W(linear_));
   }
 
-  constexpr const size_t linear(void) const {
-    /* we reuse the normaliseOffset() function and pretend this is for bank 0,
-     * so that we get a 0x0000-based offset, which we can simply add to the
-     * multiple of the bank size and have everything magically check out.
-     *
-     * This wouldn't work if we had a more complicated MBC... which I'm not sure
-     * exists for GameBoys. And, like, why would anyone create a memory map with
-     * non-constant bank sizes?
-     */
-    return linear_ ? *linear_
-                   : *bank_ * bankSize_ + normaliseOffset(0, *offset_);
-  }
+  /* we reuse the normaliseOffset() function and pretend this is for bank 0
+   * when constructing a pointer from a bank and offset, so that we get a
+   * 0x0000-based offset, which we can simply add to the multiple of the bank
+   * size and have everything magically check out.
+   *
+   * This wouldn't work if we had a more complicated MBC... which I'm not sure
+   * exists for GameBoys. And, like, why would anyone create a memory map with
+   * non-constant bank sizes?
+   */
+  constexpr const size_t linear(void) const { return linear_; }
 
   /* Bank size asserted by this pointer.
    *
@@ -91,7 +153,9 @@ class pointer {
    * Feeding in an offset will also work and so what one would expect - simply
    * returning a small number of banks.
    */
-  static constexpr const B banks(std::size_t s) { return s / bankSize_; }
+  static constexpr const std::size_t banks(std::size_t s) {
+    return s / bankSize_;
+  }
 
   constexpr pointer operator+(const ssize_t d) const {
     return asMatched(pointer{linear() + d});
@@ -110,15 +174,7 @@ class pointer {
   }
 
   pointer &operator+=(const ssize_t d) {
-    const pointer lin{linear() + d};
-
-    if (isLinear()) {
-      linear_ = lin.linear();
-    }
-    if (isBanked()) {
-      bank_ = lin.bank();
-      offset_ = lin.offset();
-    }
+    linear_ = uint32_t(linear() + d);
 
     return *this;
   }
@@ -147,9 +203,8 @@ class pointer {
   }
 
  protected:
-  std::optional<B> bank_;
-  std::optional<W> offset_;
-  std::optional<size_t> linear_;
+  uint32_t linear_;
+  bool banked_;
 
   static constexpr W normaliseOffset(B bank, W offset) {
     /* we assume the following about banks and offsets in a GameBoy ROM:
@@ -0,0 +1,603 @@
+/* Generation I data tables
+ *
+ * Decoders for the fixed-stride data tables in Pokemon Red, Blue, Green and
+ * Yellow. Records are decoded in bulk into structure-of-arrays columns, so
+ * that queries over a table are simple scans over a vector.
+ *
+ * Record layouts and symbol names follow the pokered disassembly:
+ * https://github.com/pret/pokered
+ */
+
+#if !defined(WHATCHAMAEDIT_POKEMON_H)
+#define WHATCHAMAEDIT_POKEMON_H
+
+#include <whatchamaedit/layout.h>
+#include <whatchamaedit/string.h>
+#include <whatchamaedit/view.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace pokemon {
+namespace bgry {
+/* table locations in the English Red and Blue releases.
+ *
+ * Red and Blue only have the first 150 Pokemon in BaseStats, Mew's record is
+ * stored on its own in bank 0.
+ */
+namespace location {
+static constexpr std::size_t baseStats = 0x383de;     // BaseStats, 0e:43de
+static constexpr std::size_t mewBaseStats = 0x425b;   // MewBaseStats, 01:425b
+static constexpr std::size_t moves = 0x38000;         // Moves, 0e:4000
+static constexpr std::size_t itemPrices = 0x4608;     // ItemPrices, 01:4608
+static constexpr std::size_t baseStatsCount = 150;
+static constexpr std::size_t movesCount = 165;
+static constexpr std::size_t itemPricesCount = 97;
+
+static constexpr std::size_t monsterNames = 0x1c21e;  // MonsterNames, 07:421e
+static constexpr std::size_t moveNames = 0xb0000;     // MoveNames, 2c:4000
+static constexpr std::size_t itemNames = 0x472b;      // ItemNames, 01:472b
+static constexpr std::size_t monsterNamesCount = 190;
+static constexpr std::size_t monsterNameLength = 10;
+static constexpr std::size_t moveNamesCount = 165;
+static constexpr std::size_t itemNamesCount = 97;
+
+// EvosMovesPointerTable, 0e:705c
+static constexpr std::size_t evosMoves = 0x3b05c;
+static constexpr std::size_t evosMovesCount = 190;
+}  // namespace location
+
+/* a single base stats record.
+ *
+ * The fields are annotated views, just like the ROM header's, so they can be
+ * dumped with debug::dump(). For bulk decoding, use the offsets in offset
+ * instead.
+ */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class baseStats : public gameboy::rom::view<B, W, K> {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+
+  static constexpr std::size_t stride = 28;
+
+  struct offset {
+    enum : std::size_t {
+      dex = 0,
+      hp = 1,
+      attack = 2,
+      defense = 3,
+      speed = 4,
+      special = 5,
+      type1 = 6,
+      type2 = 7,
+      catchRate = 8,
+      baseExp = 9,
+      spriteDimensions = 10,
+      frontSprite = 11,
+      backSprite = 13,
+      moves = 15,
+      growthRate = 19,
+      tmhm = 20,
+    };
+  };
+
+  /* the record's fields; addresses are relative to the record. */
+  static constexpr gameboy::layout format{
+      0,
+      gameboy::field{"dex", gameboy::dt_byte, 1},
+      gameboy::field{"stats", gameboy::dt_bytes, 5},
+      gameboy::field{"types", gameboy::dt_bytes, 2},
+      gameboy::field{"catch_rate", gameboy::dt_byte, 1},
+      gameboy::field{"base_exp", gameboy::dt_byte, 1},
+      gameboy::field{"sprite_dimensions", gameboy::dt_byte, 1},
+      gameboy::field{"front_pic", gameboy::dt_word, 2},
+      gameboy::field{"back_pic", gameboy::dt_word, 2},
+      gameboy::field{"level1_moves", gameboy::dt_bytes, 4},
+      gameboy::field{"growth_rate", gameboy::dt_byte, 1},
+      gameboy::field{"tmhm", gameboy::dt_bytes, 7},
+  };
+
+  static_assert(format.disjoint(), "base stats fields overlap");
+  static_assert(format.end() <= stride, "base stats don't fit their stride");
+  static_assert(format[format.index("front_pic")].address ==
+                        offset::frontSprite &&
+                    format[format.index("level1_moves")].address ==
+                        offset::moves &&
+                    format[format.index("tmhm")].address == offset::tmhm,
+                "base stats offsets don't match their format");
+
+  baseStats(view v)
+      : view{v.asLittleEndian()},
+        number{format.at(v, 0)},
+        stats{format.at(v, 1)},
+        types{format.at(v, 2)},
+        catchRate{format.at(v, 3)},
+        baseExp{format.at(v, 4)},
+        spriteDimensions{format.at(v, 5)},
+        frontSprite{format.at(v, 6)},
+        backSprite{format.at(v, 7)},
+        moves{format.at(v, 8)},
+        growthRate{format.at(v, 9)},
+        tmhm{format.at(v, 10)} {}
+
+  view number;
+  view stats;
+  view types;
+  view catchRate;
+  view baseExp;
+  view spriteDimensions;
+  view frontSprite;
+  view backSprite;
+  view moves;
+  view growthRate;
+  view tmhm;
+
+  std::array<view, 11> fields(void) const {
+    return {number,
+            stats,
+            types,
+            catchRate,
+            baseExp,
+            spriteDimensions,
+            frontSprite,
+            backSprite,
+            moves,
+            growthRate,
+            tmhm};
+  }
+};
+
+/* a move record: animation, effect, power, type, accuracy and PP. */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class move : public gameboy::rom::view<B, W, K> {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+
+  static constexpr std::size_t stride = 6;
+
+  struct offset {
+    enum : std::size_t {
+      animation = 0,
+      effect = 1,
+      power = 2,
+      type = 3,
+      accuracy = 4,
+      pp = 5,
+    };
+  };
+
+  move(view v) : view{v.is(gameboy::dt_bytes).label("move")} {}
+};
+
+/* an item price, 3 bytes of big endian BCD. */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class price : public gameboy::rom::view<B, W, K> {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+
+  static constexpr std::size_t stride = 3;
+
+  price(view v) : view{v.is(gameboy::dt_bytes).label("item_price")} {}
+
+  static uint32_t decode(const std::basic_string_view<B> bcd) {
+    uint32_t v = 0;
+
+    for (const auto b : bcd) {
+      v = v * 100 + (b >> 4) * 10 + (b & 0xf);
+    }
+
+    return v;
+  }
+};
+
+/* select rows of a column.
+ *
+ * Returns the indices of all rows in @column for which @p is true, e.g.
+ * where(stats.speed, [](auto s) { return s > 100; }).
+ */
+template <typename T, typename P>
+static std::vector<std::size_t> where(const std::vector<T> &column, P p) {
+  std::vector<std::size_t> rv{};
+
+  for (std::size_t i = 0; i < column.size(); i++) {
+    if (p(column[i])) {
+      rv.push_back(i);
+    }
+  }
+
+  return rv;
+}
+
+/* all of the base stats, as columns.
+ *
+ * Row i is the Pokemon with Pokedex number i + 1.
+ */
+class stats {
+ public:
+  std::vector<uint8_t> dex, hp, attack, defense, speed, special, type1, type2,
+      catchRate, baseExp, spriteDimensions, growthRate;
+  std::vector<uint16_t> frontSprite, backSprite;
+  std::array<std::vector<uint8_t>, 4> moves;
+  std::vector<std::array<uint8_t, 7>> tmhm;
+
+  std::size_t size(void) const { return dex.size(); }
+
+  template <typename view>
+  void decode(const view &table, const std::size_t count) {
+    using record = baseStats<uint8_t, uint16_t, typename view::bank>;
+
+    const gameboy::rom::container::array<view, record> a{table, count};
+
+    reserve(size() + a.count());
+
+    a.each([this](std::size_t, const auto r) {
+      dex.push_back(r[record::offset::dex]);
+      hp.push_back(r[record::offset::hp]);
+      attack.push_back(r[record::offset::attack]);
+      defense.push_back(r[record::offset::defense]);
+      speed.push_back(r[record::offset::speed]);
+      special.push_back(r[record::offset::special]);
+      type1.push_back(r[record::offset::type1]);
+      type2.push_back(r[record::offset::type2]);
+      catchRate.push_back(r[record::offset::catchRate]);
+      baseExp.push_back(r[record::offset::baseExp]);
+      spriteDimensions.push_back(r[record::offset::spriteDimensions]);
+      frontSprite.push_back(r[record::offset::frontSprite] |
+                            r[record::offset::frontSprite + 1] << 8);
+      backSprite.push_back(r[record::offset::backSprite] |
+                           r[record::offset::backSprite + 1] << 8);
+      for (std::size_t m = 0; m < moves.size(); m++) {
+        moves[m].push_back(r[record::offset::moves + m]);
+      }
+      growthRate.push_back(r[record::offset::growthRate]);
+
+      std::array<uint8_t, 7> t;
+      std::copy(r.begin() + record::offset::tmhm,
+                r.begin() + record::offset::tmhm + t.size(), t.begin());
+      tmhm.push_back(t);
+    });
+  }
+
+ protected:
+  void reserve(const std::size_t n) {
+    for (auto *c : {&dex, &hp, &attack, &defense, &speed, &special, &type1,
+                    &type2, &catchRate, &baseExp, &spriteDimensions,
+                    &growthRate}) {
+      c->reserve(n);
+    }
+    for (auto &m : moves) {
+      m.reserve(n);
+    }
+    frontSprite.reserve(n);
+    backSprite.reserve(n);
+    tmhm.reserve(n);
+  }
+};
+
+/* all of the moves, as columns.
+ *
+ * Row i is move number i + 1.
+ */
+class moves {
+ public:
+  std::vector<uint8_t> animation, effect, power, type, accuracy, pp;
+
+  std::size_t size(void) const { return animation.size(); }
+
+  template <typename view>
+  void decode(const view &table, const std::size_t count) {
+    using record = move<uint8_t, uint16_t, typename view::bank>;
+
+    const gameboy::rom::container::array<view, record> a{table, count};
+
+    for (auto *c : {&animation, &effect, &power, &type, &accuracy, &pp}) {
+      c->reserve(c->size() + a.count());
+    }
+
+    a.each([this](std::size_t, const auto r) {
+      animation.push_back(r[record::offset::animation]);
+      effect.push_back(r[record::offset::effect]);
+      power.push_back(r[record::offset::power]);
+      type.push_back(r[record::offset::type]);
+      accuracy.push_back(r[record::offset::accuracy]);
+      pp.push_back(r[record::offset::pp]);
+    });
+  }
+};
+
+/* all of the item prices.
+ *
+ * Row i is item number i + 1.
+ */
+class prices {
+ public:
+  std::vector<uint32_t> price;
+
+  std::size_t size(void) const { return price.size(); }
+
+  template <typename view>
+  void decode(const view &table, const std::size_t count) {
+    using record = bgry::price<uint8_t, uint16_t, typename view::bank>;
+
+    const gameboy::rom::container::array<view, record> a{table, count};
+
+    price.reserve(price.size() + a.count());
+
+    a.each([this](std::size_t, const auto r) {
+      price.push_back(record::decode(r));
+    });
+  }
+};
+
+/* the Gen I data tables of a ROM, decoded in one go.
+ *
+ * The tables are looked for where the English Red and Blue releases have them,
+ * so each one is checked before it's decoded, and left empty if its records
+ * don't make sense there: base stats need Pokedex numbers in order and known
+ * types, moves known types and no more than 40 PP, and prices valid BCD. Yellow
+ * keeps Mew at the end of BaseStats, which is used if there's no record of its
+ * own.
+ */
+class tables {
+ public:
+  template <typename view>
+  tables(const view &rom) {
+    using record = baseStats<uint8_t, uint16_t, typename view::bank>;
+
+    const view base = rom.from(location::baseStats);
+    const view mew = rom.from(location::mewBaseStats);
+    const view last = rom.from(location::baseStats +
+                               location::baseStatsCount * record::stride);
+
+    if (isStats(base, location::baseStatsCount)) {
+      stats.decode(base, location::baseStatsCount);
+
+      if (isStats(mew, 1, location::baseStatsCount + 1)) {
+        stats.decode(mew, 1);
+      } else if (isStats(last, 1, location::baseStatsCount + 1)) {
+        stats.decode(last, 1);
+      }
+    }
+
+    if (isMoves(rom.from(location::moves), location::movesCount)) {
+      moves.decode(rom.from(location::moves), location::movesCount);
+    }
+
+    if (isPrices(rom.from(location::itemPrices), location::itemPricesCount)) {
+      prices.decode(rom.from(location::itemPrices), location::itemPricesCount);
+    }
+  }
+
+  bgry::stats stats;
+  bgry::moves moves;
+  bgry::prices prices;
+
+ protected:
+  /* NORMAL to GHOST, then FIRE to DRAGON; see constants/type_constants.asm. */
+  static constexpr bool isType(const uint8_t t) {
+    return t <= 0x08 || (t >= 0x14 && t <= 0x1a);
+  }
+
+  /* whether @table has @count base stats records, numbered from @dex on. */
+  template <typename view>
+  static bool isStats(const view &table, const std::size_t count,
+                      const std::size_t dex = 1) {
+    using record = baseStats<uint8_t, uint16_t, typename view::bank>;
+
+    const gameboy::rom::container::array<view, record> a{table, count};
+    bool rv = a.count() == count;
+
+    a.each([&rv, dex](std::size_t i, const auto r) {
+      rv = rv && r[record::offset::dex] == dex + i &&
+           isType(r[record::offset::type1]) && isType(r[record::offset::type2]);
+    });
+
+    return rv;
+  }
+
+  template <typename view>
+  static bool isMoves(const view &table, const std::size_t count) {
+    using record = move<uint8_t, uint16_t, typename view::bank>;
+
+    const gameboy::rom::container::array<view, record> a{table, count};
+    bool rv = a.count() == count;
+
+    a.each([&rv](std::size_t, const auto r) {
+      rv = rv && isType(r[record::offset::type]) && r[record::offset::pp] <= 40;
+    });
+
+    return rv;
+  }
+
+  template <typename view>
+  static bool isPrices(const view &table, const std::size_t count) {
+    using record = price<uint8_t, uint16_t, typename view::bank>;
+
+    const gameboy::rom::container::array<view, record> a{table, count};
+    bool rv = a.count() == count;
+
+    a.each([&rv](std::size_t, const auto r) {
+      for (const auto b : r) {
+        rv = rv && (b >> 4) <= 9 && (b & 0xf) <= 9;
+      }
+    });
+
+    return rv;
+  }
+};
+
+/* a single evolution: how, and into which Pokemon.
+ *
+ * Evolutions by level or trade are 3 bytes, those by item 4: the method, the
+ * item if any, the level and the internal index of the new Pokemon.
+ */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class evolution : public gameboy::rom::view<B, W, K> {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+
+  enum method : uint8_t {
+    ev_level = 1,
+    ev_item = 2,
+    ev_trade = 3,
+  };
+
+  evolution(view v)
+      : view{v.length(first(v) == ev_item ? 4 : 3)
+                 .is(gameboy::dt_bytes)
+                 .label("evolution")} {}
+
+  operator bool(void) const {
+    return view(*this) && how() >= ev_level && how() <= ev_trade;
+  }
+
+  method how(void) const { return method(first(*this)); }
+
+  uint8_t item(void) const { return how() == ev_item ? at(1) : 0; }
+
+  uint8_t level(void) const { return at(view::size() - 2); }
+
+  uint8_t species(void) const { return at(view::size() - 1); }
+
+ protected:
+  static uint8_t first(const view &v) {
+    const auto r = v.raw();
+    return r.empty() ? 0 : r[0];
+  }
+
+  uint8_t at(const std::size_t i) const {
+    const auto r = view::raw();
+    return i < r.size() ? r[i] : 0;
+  }
+};
+
+/* a move learned by levelling up: the level, then the move. */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class learn : public gameboy::rom::view<B, W, K> {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+
+  learn(view v) : view{v.length(2).is(gameboy::dt_bytes).label("learn")} {}
+
+  operator bool(void) const { return view(*this) && level() != 0; }
+
+  uint8_t level(void) const { return at(0); }
+
+  uint8_t move(void) const { return at(1); }
+
+ protected:
+  uint8_t at(const std::size_t i) const {
+    const auto r = view::raw();
+    return i < r.size() ? r[i] : 0;
+  }
+};
+
+/* the evolutions and level-up moves of every Pokemon.
+ *
+ * Each Pokemon's entry is a list of evolutions followed by a list of moves,
+ * each ending in a 0 byte, so finding the moves means walking the evolutions
+ * first. Neither list is decoded until it's iterated over, and nothing is
+ * kept, so walking all of them doesn't allocate. Entries are in internal
+ * index order.
+ */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class evosMoves {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+  using evolutions =
+      gameboy::rom::container::sequence<view, evolution<B, W, K>>;
+  using learnset = gameboy::rom::container::sequence<view, learn<B, W, K>>;
+
+  evosMoves(const view &rom)
+      : rom_{rom},
+        table_{rom.from(location::evosMoves)
+                   .length(location::evosMovesCount * 2)
+                   .raw()} {}
+
+  std::size_t count(void) const { return table_.size() / 2; }
+
+  /* where the i-th entry starts. */
+  pointer at(const std::size_t i) const {
+    return pointer{K(pointer::banks(location::evosMoves)),
+                   W(table_[2 * i] | table_[2 * i + 1] << 8)};
+  }
+
+  evolutions evolutionsOf(const std::size_t i) const {
+    return evolutions::terminated(rom_.from(at(i)), 0);
+  }
+
+  learnset learnsetOf(const std::size_t i) const {
+    return learnset::terminated(rom_.from(evolutionsOf(i).extent()), 0);
+  }
+
+ protected:
+  const view rom_;
+  const std::basic_string_view<B> table_;
+};
+
+/* the Gen I name lists of a ROM.
+ *
+ * Pokemon names are in internal index order rather than Pokedex order, and are
+ * padded to a fixed length; move and item names simply follow each other.
+ * All three lists are indexed once on construction, so looking up any name is
+ * a constant time operation.
+ *
+ * Like the tables, the lists are looked for where Red and Blue have them, and
+ * each one is left empty unless all of its names are text in @language: at
+ * least one letter, and nothing that ends a string before the terminator.
+ */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class names {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using string = gameboy::rom::string<B, W, K>;
+  using list = gameboy::rom::container::indirect<
+      view, string, std::reference_wrapper<const text::language>>;
+
+  names(const view &rom,
+        const text::language &language = text::languages::english)
+      : monsters{checked(rom.from(location::monsterNames),
+                         location::monsterNamesCount, language,
+                         location::monsterNameLength)},
+        moves{checked(rom.from(location::moveNames), location::moveNamesCount,
+                      language)},
+        items{checked(rom.from(location::itemNames), location::itemNamesCount,
+                      language)} {}
+
+  list monsters;
+  list moves;
+  list items;
+
+ protected:
+  /* the list of @count names at @v, or an empty one if that isn't one. */
+  static list checked(const view &v, const std::size_t count,
+                      const text::language &language,
+                      const std::size_t length = 0) {
+    const list l{v, count, B(language.end()), length, std::cref(language)};
+    bool ok = l.count() == count;
+
+    for (std::size_t i = 0; ok && i < count; i++) {
+      bool letters = false;
+
+      for (const auto b : l.raw(i).raw()) {
+        if (b == language.end()) {
+          break;
+        }
+
+        letters = letters || language.text(b);
+        ok = ok && !language.ends(b);
+      }
+
+      ok = ok && letters;
+    }
+
+    return ok ? l : list{v, 0, B(language.end()), length, std::cref(language)};
+  }
+};
+}  // namespace bgry
+}  // namespace pokemon
+
+#endif
@@ -0,0 +1,282 @@
+/* Block relocation
+ *
+ * Moves a block of data, typically text that no longer fits where it used to
+ * be, to somewhere else in the ROM and updates everything that points into it.
+ * References come from an xref index, so anything that merely looks like a
+ * pointer is a candidate; pass a filter to only accept the ones that are
+ * plausible, e.g. those that aren't in graphics.
+ *
+ * A relocation is planned first and can be inspected with report() before it
+ * is applied, so a dry run is just not calling apply().
+ */
+
+#if !defined(WHATCHAMAEDIT_RELOCATE_H)
+#define WHATCHAMAEDIT_RELOCATE_H
+
+#include <whatchamaedit/view.h>
+#include <whatchamaedit/xref.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class relocation {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+  using xref = gameboy::rom::xref<B, W, K>;
+  using reference = typename xref::reference;
+  using bytes = std::basic_string<B>;
+
+  /* a single write the relocation will make. */
+  struct change {
+    pointer at;
+    bytes before;
+    bytes after;
+    std::string what;
+  };
+
+  /** @constructor
+   *
+   * @rom the ROM the block is in.
+   * @index the cross references of @rom.
+   * @block the block to move.
+   * @destination where to move it to; this should be free space of at least
+   * the block's size, e.g. from freespace::allocate().
+   * @accept called with every reference into the block; only references it
+   * returns true for are updated.
+   */
+  template <typename F>
+  relocation(const view &rom, const xref &index, const view &block,
+             const pointer destination, F accept)
+      : source_{block.startPtr()},
+        destination_{destination},
+        length_{std::size_t(block.size())} {
+    const std::size_t src = source_.linear();
+    const std::size_t dst = destination_.linear();
+
+    if (length_ == 0 || src + length_ > rom.dataSize() ||
+        dst + length_ > rom.dataSize()) {
+      problems_.push_back("block or destination is not inside the ROM");
+      return;
+    }
+
+    if (src < dst + length_ && dst < src + length_) {
+      problems_.push_back("destination overlaps the block");
+      return;
+    }
+
+    if (destination_.bank() != pointer{dst + length_ - 1}.bank()) {
+      problems_.push_back("block would cross a bank boundary at destination");
+      return;
+    }
+
+    const auto data = rom.raw();
+
+    changes_.push_back({destination_, bytes(data.substr(dst, length_)),
+                        bytes(data.substr(src, length_)), "block"});
+
+    /* there's a near and a far reference at the same place if a bank byte
+     * happens to precede or follow an offset; the far one wins, as it's the
+     * more specific of the two. */
+    std::map<std::size_t, std::pair<reference, std::size_t>> found{};
+
+    for (std::size_t t = src; t < src + length_; t++) {
+      for (const auto &r : index.to(pointer{t})) {
+        if (!accept(r)) {
+          continue;
+        }
+
+        auto [it, added] = found.insert({r.at, {r, t}});
+        if (!added && it->second.first.type == xref::near &&
+            r.type != xref::near) {
+          it->second = {r, t};
+        }
+      }
+    }
+
+    for (const auto &[at, ref] : found) {
+      plan(data, ref.first, ref.second);
+    }
+
+    std::sort(changes_.begin() + 1, changes_.end(),
+              [](const auto &a, const auto &b) { return a.at < b.at; });
+
+    /* overlapping references can't both be real, and we can't tell which one
+     * isn't, so leave that decision to whoever filters them. */
+    for (std::size_t i = 2; i < changes_.size(); i++) {
+      const auto &a = changes_[i - 1];
+      const auto &b = changes_[i];
+
+      if (b.at.linear() < a.at.linear() + a.after.size()) {
+        problems_.push_back("references at " + hex(a.at.linear()) + " and " +
+                            hex(b.at.linear()) + " overlap");
+      }
+    }
+  }
+
+  relocation(const view &rom, const xref &index, const view &block,
+             const pointer destination)
+      : relocation(rom, index, block, destination,
+                   [](const reference &) { return true; }) {}
+
+  /* whether the relocation can be applied as planned. */
+  bool ok(void) const { return problems_.empty(); }
+
+  const std::vector<change> &changes(void) const { return changes_; }
+
+  /* reasons why the relocation can't be applied. */
+  const std::vector<std::string> &problems(void) const { return problems_; }
+
+  /* references that were found but not updated, e.g. because they're in
+   * bank 0 and don't say which bank they're for. */
+  const std::vector<std::string> &warnings(void) const { return warnings_; }
+
+  /* describe what apply() would do. */
+  void report(std::ostream &out) const {
+    out << "move 0x" << std::hex << std::setfill('0') << std::setw(6)
+        << source_.linear() << "-0x" << std::setw(6)
+        << source_.linear() + length_ - 1 << " (" << std::dec << length_
+        << " bytes) to 0x" << std::hex << std::setw(6)
+        << destination_.linear() << "\n";
+
+    for (const auto &c : changes_) {
+      if (c.what == "block") {
+        continue;
+      }
+
+      out << "  0x" << std::hex << std::setw(6) << c.at.linear() << " "
+          << c.what << ":";
+      for (const auto b : c.before) {
+        out << " " << std::setw(2) << unsigned(uint8_t(b));
+      }
+      out << " ->";
+      for (const auto b : c.after) {
+        out << " " << std::setw(2) << unsigned(uint8_t(b));
+      }
+      out << "\n";
+    }
+
+    for (const auto &w : warnings_) {
+      out << "  warning: " << w << "\n";
+    }
+
+    for (const auto &p : problems_) {
+      out << "  error: " << p << "\n";
+    }
+
+    out << std::dec;
+  }
+
+  /* apply the relocation.
+   *
+   * @rom the ROM to change; needs to provide write(), checkpoint(),
+   * fixHeaderChecksum() and fixChecksum() like whatchamaedit::rom::gb does.
+   *
+   * The block is copied first and references are updated afterwards, which
+   * matters for references inside the block itself. All of it, including the
+   * checksum fixes, is a single group in the ROM's undo history. Nothing is
+   * written if there are any problems.
+   */
+  template <typename R>
+  bool apply(R &rom) const {
+    if (!ok()) {
+      return false;
+    }
+
+    rom.checkpoint();
+
+    for (const auto &c : changes_) {
+      rom.write(c.at, c.after);
+    }
+
+    rom.fixHeaderChecksum();
+    rom.fixChecksum();
+
+    rom.checkpoint();
+
+    return true;
+  }
+
+ protected:
+  const pointer source_;
+  const pointer destination_;
+  const std::size_t length_;
+  std::vector<change> changes_{};
+  std::vector<std::string> problems_{};
+  std::vector<std::string> warnings_{};
+
+  /* where a byte ends up after the relocation. */
+  std::size_t moved(const std::size_t p) const {
+    const std::size_t src = source_.linear();
+
+    return src <= p && p < src + length_ ? p - src + destination_.linear() : p;
+  }
+
+  static std::string hex(const std::size_t v) {
+    std::ostringstream os{};
+    os << "0x" << std::hex << std::setfill('0') << std::setw(6) << v;
+    return os.str();
+  }
+
+  void plan(const std::basic_string_view<B> data, const reference &r,
+            const std::size_t target) {
+    const pointer to{moved(target)};
+    const pointer at{moved(r.at)};
+    const std::size_t offset = to.offset();
+    const B word[2]{B(offset & 0xff), B(offset >> 8)};
+
+    switch (r.type) {
+      case xref::near:
+        if (to.bank() != 0 && to.bank() != at.bank()) {
+          problems_.push_back("near reference at " + hex(r.at) +
+                              " can't reach bank " + hex(to.bank()));
+          return;
+        }
+
+        changes_.push_back({at, bytes(data.substr(r.at, 2)), bytes(word, 2),
+                            "near      "});
+        break;
+      case xref::bankFirst:
+      case xref::bankLast: {
+        if (to.bank() == 0) {
+          problems_.push_back("far reference at " + hex(r.at) +
+                              " can't point into bank 0");
+          return;
+        }
+
+        if (std::size_t(to.bank()) > 0xff) {
+          problems_.push_back("far reference at " + hex(r.at) +
+                              " can't hold bank " + hex(to.bank()));
+          return;
+        }
+
+        const bool first = r.type == xref::bankFirst;
+        const std::size_t start = first ? r.at - 1 : r.at;
+        const B far[3]{first ? B(to.bank()) : word[0],
+                       first ? word[0] : word[1],
+                       first ? word[1] : B(to.bank())};
+
+        changes_.push_back({pointer{moved(start)},
+                            bytes(data.substr(start, 3)), bytes(far, 3),
+                            first ? "bank first" : "bank last "});
+        break;
+      }
+      case xref::unbanked:
+        warnings_.push_back("reference from bank 0 at " + hex(r.at) +
+                            " doesn't say which bank it's for; not updated");
+        break;
+    }
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
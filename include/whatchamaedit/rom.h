@@ -1,38 +1,202 @@
 #if !defined(WHATCHAMAEDIT_ROM_H)
 #define WHATCHAMAEDIT_ROM_H
 
+#include <whatchamaedit/classify.h>
+#include <whatchamaedit/detect.h>
 #include <whatchamaedit/header.h>
 #include <whatchamaedit/image.h>
+#include <whatchamaedit/pipeline.h>
+#include <whatchamaedit/pokemon.h>
+#include <whatchamaedit/search.h>
 #include <whatchamaedit/string.h>
+#include <whatchamaedit/writer.h>
 
+#include <algorithm>
+#include <fstream>
+#include <memory>
 #include <sstream>
+#include <vector>
 
 namespace whatchamaedit {
 namespace rom {
-template <typename B = char>
-class gb : public gameboy::rom::image<> {
+/* a GameBoy ROM.
+ *
+ * @K the type of a bank number. A byte covers up to 256 banks, i.e. 4 MiB,
+ * which is all that MBC1 and MBC3 can address; MBC5 ROMs and hacks that have
+ * been expanded to its limits have up to 512 banks, and need a wider type.
+ * wide() tells which one a ROM file needs.
+ */
+template <typename K = uint8_t>
+class gb : public gameboy::rom::image<uint8_t, uint16_t, K> {
  public:
-  using image = gameboy::rom::image<>;
+  using image = gameboy::rom::image<uint8_t, uint16_t, K>;
   using pointer = typename image::pointer;
   using view = typename image::view;
-  using string = gameboy::rom::string<>;
+  using string = gameboy::rom::string<uint8_t, uint16_t, K>;
+  using stringTable = gameboy::rom::stringTable<uint8_t, uint16_t, K>;
+  using textIndex = gameboy::rom::textIndex<uint8_t, uint16_t, K>;
+  using classify = gameboy::rom::classify<uint8_t, uint16_t, K>;
+  using detect = gameboy::rom::detect<uint8_t, uint16_t, K>;
+  using writer = gameboy::rom::writer<uint8_t, uint16_t, K>;
 
-  gb(const std::string &file) : image(file), header{*this} {}
+  using image::checkpoint;
+  using image::revision;
+  using image::write;
 
-  std::string getString(long start, long end) const {
-    return string{view{*this}.from(start).to(end)}.translated();
+  gb(const std::string &file) : image(file), header{*this} {
+    image::subscribe([this](const std::size_t offset, const std::size_t n) {
+      if (!strings_) {
+        return;
+      }
+
+      /* typing into a string changes one byte after the other, so merge
+       * changes that touch the previous one. */
+      if (!changed_.empty() && changed_.back().first <= offset + n &&
+          offset <= changed_.back().second) {
+        changed_.back().first = std::min(changed_.back().first, offset);
+        changed_.back().second = std::max(changed_.back().second, offset + n);
+      } else {
+        changed_.push_back({offset, offset + n});
+      }
+    });
   }
 
-  std::map<pointer, std::string> getStrings(void) const {
-    std::map<pointer, std::string> rv;
+  /* the image tells this ROM about changes, so it can't be copied. */
+  gb(const gb &) = delete;
+  gb &operator=(const gb &) = delete;
+
+  /* whether the ROM in @file has more banks than fit into a byte.
+   *
+   * Goes by whichever is larger, the ROM size in the header or the size of
+   * the file, since expanded hacks don't always update the header.
+   */
+  static bool wide(const std::string &file) {
+    std::ifstream rom(file, std::ios::in | std::ios::binary | std::ios::ate);
+    const std::size_t size = rom ? std::size_t(rom.tellg()) : 0;
+    char flags = 0;
+
+    rom.seekg(0x148);
+    rom.read(&flags, 1);
+
+    const std::size_t banks =
+        std::max(rom && uint8_t(flags) <= 8 ? std::size_t(2) << flags : 0,
+                 pointer::banks(size));
+
+    return banks > 0x100;
+  }
 
-    for (const auto &p : string{view{*this}}.scan()) {
-      rv[p] = string{view{*this}.from(p)}.translated();
+  /* the language the ROM's text is in, as far as its charmap goes.
+   *
+   * Detected on first use, unless one has been set before that.
+   */
+  const text::language &language(void) const {
+    if (language_ == nullptr) {
+      language_ = &detect{view{*this}}.best();
     }
 
+    return *language_;
+  }
+
+  /* decode the ROM's text as @l from now on, instead of what was detected;
+   * @l needs to outlive the ROM, which the ones in text::languages do. */
+  void language(const text::language &l) {
+    language_ = &l;
+    names_.reset();
+    regions_.reset();
+    strings_.reset();
+    search_.reset();
+    changed_.clear();
+  }
+
+  std::string getString(long start, long end) const {
+    return string{view{*this}.from(start).to(end), language()}.translated();
+  }
+
+  /* find all strings in the ROM.
+   *
+   * @skipData only look at blocks that regions() didn't classify as code,
+   * graphics, padding or pointer tables.
+   *
+   * This collects everything; use strings() and decode() to handle strings
+   * as they're found instead.
+   */
+  stringTable getStrings(const bool skipData = false) const {
+    stringTable rv{language()};
+    const view v{*this};
+
+    const auto collect = [&rv, &v](const pointer p) { rv.add(v.from(p)); };
+
+    strings(skipData) | gameboy::pipeline::each(collect);
+
     return rv;
   }
 
+  /* a pipeline source with where each string in the ROM starts, in address
+   * order; see getStrings() for @skipData. The ROM needs to outlive it. */
+  auto strings(const bool skipData = false) const {
+    return gameboy::pipeline::source{[this, skipData](const auto &sink) {
+      const auto &l = language();
+      const auto keep = [this, skipData](const pointer p) {
+        return !skipData || !inData(p);
+      };
+
+      string{view{*this}, l}.scan(keep, sink);
+    }};
+  }
+
+  /* a pipeline stage that turns where a string starts into that and the
+   * string's text.
+   *
+   * The text is decoded into a buffer that's reused for every string, so it's
+   * only valid until the next string comes through.
+   */
+  auto decode(void) const {
+    const auto buffer = std::make_shared<std::string>();
+
+    return gameboy::pipeline::transform(
+        [v = view{*this}, l = &language(), buffer](const pointer p) {
+          buffer->clear();
+          string{v.from(p), *l}.translate(*buffer);
+          return std::make_pair(p, std::string_view{*buffer});
+        });
+  }
+
+  /* all strings in the ROM, like getStrings() finds them.
+   *
+   * Scanned on first use; after that, only the strings around parts of the
+   * ROM that have changed since are scanned again.
+   */
+  const stringTable &stringIndex(void) const {
+    if (!strings_) {
+      strings_ = getStrings();
+      changed_.clear();
+    }
+
+    const view v{*this};
+
+    for (const auto &c : changed_) {
+      strings_->update(v, c.first, c.second);
+    }
+
+    changed_.clear();
+
+    return *strings_;
+  }
+
+  /* all strings that contain @query, like stringIndex() has them.
+   *
+   * The search index is built on first use and then cached until the ROM is
+   * next changed.
+   */
+  std::vector<typename stringTable::entry> grep(
+      const std::string_view query) const {
+    if (!search_ || search_->first != revision()) {
+      search_.emplace(revision(), textIndex{stringIndex()});
+    }
+
+    return search_->second.find(query);
+  }
+
   std::string title(void) const { return std::string(header.title); }
 
   long romChecksum(void) const { return header.checksumR(true); }
@@ -44,20 +208,88 @@ class gb : public gameboy::rom::image<> {
   }
 
   bool fixChecksum(void) {
-    uint16_t checksum = romChecksum();
+    field(header.f_globalChecksum).word(romChecksum());
 
-    static const long high = 0x14e;
-    static const long low = 0x14f;
+    return this->checksum();
+  }
 
-    data_[high] = checksum >> 8;
-    data_[low] = checksum & 0xff;
+  /* fix the header checksum.
+   *
+   * The global checksum covers the header checksum, so if you need to fix both
+   * then fix this one first.
+   */
+  bool fixHeaderChecksum(void) {
+    field(header.f_headerChecksum).byte(header.checksumH(true));
 
-    return this->checksum();
+    return header.checksumH(true) == header.checksumH(false);
+  }
+
+  /* Gen I data tables.
+   *
+   * Decoded on first use and then cached until the ROM is next changed.
+   */
+  const pokemon::bgry::tables &tables(void) const {
+    if (!tables_ || tables_->first != revision()) {
+      tables_.emplace(revision(), pokemon::bgry::tables{view{*this}});
+    }
+
+    return tables_->second;
   }
 
-  gameboy::rom::header<> header;
+  /* Gen I name lists.
+   *
+   * Indexed on first use and then cached until the ROM is next changed.
+   */
+  const pokemon::bgry::names<uint8_t, uint16_t, K> &names(void) const {
+    if (!names_ || names_->first != revision()) {
+      names_.emplace(revision(),
+                     pokemon::bgry::names<uint8_t, uint16_t, K>{view{*this},
+                                                                language()});
+    }
+
+    return names_->second;
+  }
+
+  /* what each 256 byte block of the ROM appears to be.
+   *
+   * Classified on first use and then cached until the ROM is next changed.
+   */
+  const classify &regions(void) const {
+    if (!regions_ || regions_->first != revision()) {
+      regions_.emplace(revision(), classify{view{*this}, language()});
+    }
+
+    return regions_->second;
+  }
+
+  /* whether regions() has @p down as code, graphics, padding or a pointer
+   * table, i.e. somewhere strings(true) doesn't look. */
+  bool inData(const pointer p) const {
+    const auto r = regions().at(p);
+    return r != gameboy::r_text && r != gameboy::r_unknown;
+  }
+
+  /* a writer for one of the cartridge header's fields. */
+  writer field(
+      const typename gameboy::rom::header<uint8_t, uint16_t, K>::slot f) {
+    return writer{*this, header.format.at(view{*this}, f)};
+  }
+
+  gameboy::rom::header<uint8_t, uint16_t, K> header;
+
+  operator bool(void) const { return image::loadOK && header; }
 
-  operator bool(void) const { return loadOK && header; }
+ protected:
+  mutable std::optional<std::pair<std::size_t, pokemon::bgry::tables>>
+      tables_;
+  mutable std::optional<
+      std::pair<std::size_t, pokemon::bgry::names<uint8_t, uint16_t, K>>>
+      names_;
+  mutable std::optional<std::pair<std::size_t, classify>> regions_;
+  mutable std::optional<stringTable> strings_;
+  mutable std::optional<std::pair<std::size_t, textIndex>> search_;
+  mutable const text::language *language_{nullptr};
+  mutable std::vector<std::pair<std::size_t, std::size_t>> changed_;
 };
 }  // namespace rom
 }  // namespace whatchamaedit
@@ -0,0 +1,128 @@
+/* Text search
+ *
+ * Finds decoded text, rather than bytes, in a table of strings. Every three
+ * byte sequence of each string's text is a trigram, and the index keeps a
+ * list of the strings each trigram occurs in. A query only has to look at the
+ * strings on the shortest list among its own trigrams, which is usually a
+ * small fraction of all of them.
+ *
+ * The lists are kept one after the other in a single flat array, sorted by
+ * trigram, so the index is only a few allocations no matter how much text
+ * there is.
+ */
+
+#if !defined(WHATCHAMAEDIT_SEARCH_H)
+#define WHATCHAMAEDIT_SEARCH_H
+
+#include <whatchamaedit/string.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class textIndex {
+ public:
+  using strings = gameboy::rom::stringTable<B, W, K>;
+  using entry = typename strings::entry;
+
+  textIndex(strings s) : strings_{std::move(s)} {
+    std::vector<std::pair<uint32_t, uint32_t>> pairs{};
+    pairs.reserve(strings_.text().size());
+
+    for (std::size_t i = 0; i < strings_.size(); i++) {
+      const auto t = strings_[i].second;
+
+      for (std::size_t j = 0; j + 3 <= t.size(); j++) {
+        pairs.push_back({trigram(t, j), uint32_t(i)});
+      }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    postings_.reserve(pairs.size());
+
+    for (const auto &[t, i] : pairs) {
+      if (trigrams_.empty() || trigrams_.back() != t) {
+        trigrams_.push_back(t);
+        starts_.push_back(uint32_t(postings_.size()));
+      }
+
+      postings_.push_back(i);
+    }
+
+    starts_.push_back(uint32_t(postings_.size()));
+  }
+
+  /* all strings that contain @query, in address order.
+   *
+   * Queries are matched exactly, against the decoded text, so they can span
+   * multi-character glyphs like POKé. Queries that are shorter than a trigram
+   * have to check every string.
+   */
+  std::vector<entry> find(const std::string_view query) const {
+    std::vector<entry> rv{};
+
+    if (query.empty()) {
+      return rv;
+    }
+
+    if (query.size() < 3) {
+      for (const auto &s : strings_) {
+        if (s.second.find(query) != std::string_view::npos) {
+          rv.push_back(s);
+        }
+      }
+
+      return rv;
+    }
+
+    std::size_t first = 0, last = postings_.size() + 1;
+
+    for (std::size_t j = 0; j + 3 <= query.size(); j++) {
+      const auto it = std::lower_bound(trigrams_.begin(), trigrams_.end(),
+                                       trigram(query, j));
+
+      if (it == trigrams_.end() || *it != trigram(query, j)) {
+        return rv;
+      }
+
+      const std::size_t t = it - trigrams_.begin();
+
+      if (starts_[t + 1] - starts_[t] < last - first) {
+        first = starts_[t];
+        last = starts_[t + 1];
+      }
+    }
+
+    for (std::size_t p = first; p < last; p++) {
+      const auto s = strings_[postings_[p]];
+
+      if (s.second.find(query) != std::string_view::npos) {
+        rv.push_back(s);
+      }
+    }
+
+    return rv;
+  }
+
+  const strings &all(void) const { return strings_; }
+
+ protected:
+  strings strings_;
+  std::vector<uint32_t> trigrams_{};
+  std::vector<uint32_t> starts_{};
+  std::vector<uint32_t> postings_{};
+
+  static uint32_t trigram(const std::string_view t, const std::size_t j) {
+    return uint8_t(t[j]) << 16 | uint8_t(t[j + 1]) << 8 | uint8_t(t[j + 2]);
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,299 @@
+/* Byte signatures
+ *
+ * Finds routines and tables by their bytes, with wildcards for the parts that
+ * differ between releases, like addresses. A signature is written as hex
+ * bytes, where ?? matches any byte and a single ? matches any nibble:
+ *
+ *     # name       pattern
+ *     CopyData     21 ?? ?? 11 ?? ?? 01 ?? ?? cd
+ *     LoadFont     3e 4? e0 ?? fa ?0 d7
+ *
+ * Any number of signatures are matched in a single pass over the ROM. Every
+ * signature is anchored on its rarest fully fixed byte, so only positions
+ * where one of those anchor bytes occurs are looked at in detail; finding
+ * those positions is done 16 bytes at a time with SSSE3 where available.
+ */
+
+#if !defined(WHATCHAMAEDIT_SIGNATURE_H)
+#define WHATCHAMAEDIT_SIGNATURE_H
+
+#include <whatchamaedit/view.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class signatures {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  struct signature {
+    std::string name;
+    std::vector<uint8_t> value;
+    std::vector<uint8_t> mask;
+  };
+
+  struct hit {
+    std::size_t signature;
+    pointer at;
+  };
+
+  struct error {
+    std::size_t line;
+    std::string message;
+  };
+
+  /* add a signature.
+   *
+   * Returns false if @pattern is malformed or doesn't have a single fully
+   * fixed byte to anchor it on.
+   */
+  bool add(const std::string &name, const std::string_view pattern) {
+    signature s{name, {}, {}};
+    bool fixed = false;
+
+    for (std::size_t i = 0; i < pattern.size();) {
+      if (pattern[i] == ' ' || pattern[i] == '\t') {
+        i++;
+        continue;
+      }
+
+      if (i + 1 >= pattern.size()) {
+        return false;
+      }
+
+      uint8_t value = 0, mask = 0;
+
+      for (std::size_t n = 0; n < 2; n++) {
+        const char c = pattern[i + n];
+        const unsigned shift = n == 0 ? 4 : 0;
+
+        if (c == '?') {
+          continue;
+        }
+
+        const int v = nibble(c);
+        if (v < 0) {
+          return false;
+        }
+
+        value |= v << shift;
+        mask |= 0xf << shift;
+      }
+
+      fixed = fixed || mask == 0xff;
+      s.value.push_back(value);
+      s.mask.push_back(mask);
+      i += 2;
+    }
+
+    if (!fixed) {
+      return false;
+    }
+
+    signatures_.push_back(s);
+
+    return true;
+  }
+
+  /* read signatures from a file.
+   *
+   * Every line that isn't empty or a comment is a name followed by
+   * whitespace and a pattern. Returns false if there were any malformed
+   * lines, which are also added to errors().
+   */
+  bool load(std::istream &in) {
+    bool ok = true;
+    std::string l;
+
+    while (std::getline(in, l)) {
+      line_++;
+
+      const auto start = l.find_first_not_of(" \t\r");
+      if (start == std::string::npos || l[start] == '#') {
+        continue;
+      }
+
+      const auto sep = l.find_first_of(" \t", start);
+      const auto pattern = l.find_first_not_of(" \t", sep);
+      std::string p = pattern == std::string::npos ? "" : l.substr(pattern);
+
+      if (!p.empty() && p.back() == '\r') {
+        p.pop_back();
+      }
+
+      if (!add(l.substr(start, sep - start), p)) {
+        errors_.push_back({line_, "malformed signature; every signature needs "
+                                  "at least one byte without wildcards"});
+        ok = false;
+      }
+    }
+
+    return ok;
+  }
+
+  /* find all signatures in @v, in a single pass.
+   *
+   * Hits are ordered by address.
+   */
+  std::vector<hit> find(const view &v) const {
+    const auto data = v.raw();
+    const std::size_t base = v.startPtr().linear();
+
+    std::array<std::size_t, 256> histogram{};
+    for (const auto b : data) {
+      histogram[uint8_t(b)]++;
+    }
+
+    /* per anchor byte: which signatures are anchored on it, and where. */
+    std::array<std::vector<std::pair<std::size_t, std::size_t>>, 256> anchors{};
+
+    for (std::size_t s = 0; s < signatures_.size(); s++) {
+      const auto &sig = signatures_[s];
+      std::size_t best = sig.value.size();
+
+      for (std::size_t i = 0; i < sig.value.size(); i++) {
+        if (sig.mask[i] == 0xff &&
+            (best == sig.value.size() ||
+             histogram[sig.value[i]] < histogram[sig.value[best]])) {
+          best = i;
+        }
+      }
+
+      anchors[sig.value[best]].push_back({s, best});
+    }
+
+    const filter f{anchors};
+    std::vector<hit> rv{};
+
+    f.each(data, [&](const std::size_t p) {
+      for (const auto &[s, offset] : anchors[uint8_t(data[p])]) {
+        const auto &sig = signatures_[s];
+
+        if (p >= offset && p - offset + sig.value.size() <= data.size() &&
+            matches(data.substr(p - offset, sig.value.size()), sig)) {
+          rv.push_back({s, pointer{base + p - offset}});
+        }
+      }
+    });
+
+    std::sort(rv.begin(), rv.end(), [](const hit &a, const hit &b) {
+      return a.at < b.at || (a.at == b.at && a.signature < b.signature);
+    });
+
+    return rv;
+  }
+
+  const std::vector<signature> &all(void) const { return signatures_; }
+
+  const std::vector<error> &errors(void) const { return errors_; }
+
+  std::size_t size(void) const { return signatures_.size(); }
+
+ protected:
+  std::vector<signature> signatures_{};
+  std::vector<error> errors_{};
+  std::size_t line_{0};
+
+  static constexpr int nibble(const char c) {
+    return '0' <= c && c <= '9'   ? c - '0'
+           : 'a' <= c && c <= 'f' ? c - 'a' + 10
+           : 'A' <= c && c <= 'F' ? c - 'A' + 10
+                                  : -1;
+  }
+
+  static bool matches(const std::basic_string_view<B> d, const signature &s) {
+    for (std::size_t i = 0; i < d.size(); i++) {
+      if ((uint8_t(d[i]) & s.mask[i]) != s.value[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /* finds bytes that are in a set of up to 256 values.
+   *
+   * The SSSE3 version is a 'shufti' filter: each byte's low and high nibble
+   * are looked up in two 16 entry tables of bucket bits, and a byte may be in
+   * the set if both lookups share a bucket. Bytes are sorted into buckets by
+   * their high nibble, so this can report false positives for sets with
+   * bytes of more than eight different high nibbles; every candidate is
+   * checked against the exact set as well.
+   */
+  class filter {
+   public:
+    template <typename A>
+    filter(const A &anchors) {
+      for (std::size_t b = 0; b < anchors.size(); b++) {
+        if (!anchors[b].empty()) {
+          const uint8_t bucket = 1 << ((b >> 4) & 7);
+
+          set_[b] = true;
+          low_[b & 0xf] |= bucket;
+          high_[b >> 4] |= bucket;
+        }
+      }
+    }
+
+    template <typename F>
+    void each(const std::basic_string_view<B> data, F f) const {
+      std::size_t i = 0;
+
+#if defined(__SSSE3__)
+      const __m128i low =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(low_.data()));
+      const __m128i high =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(high_.data()));
+      const __m128i nibble = _mm_set1_epi8(0xf);
+      const __m128i zero = _mm_setzero_si128();
+
+      for (; i + 16 <= data.size(); i += 16) {
+        const __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + i));
+        const __m128i l = _mm_shuffle_epi8(low, _mm_and_si128(v, nibble));
+        const __m128i h = _mm_shuffle_epi8(
+            high, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        const unsigned m = ~_mm_movemask_epi8(
+                               _mm_cmpeq_epi8(_mm_and_si128(l, h), zero)) &
+                           0xffff;
+
+        for (unsigned c = m; c != 0; c &= c - 1) {
+          const std::size_t p = i + __builtin_ctz(c);
+
+          if (set_[uint8_t(data[p])]) {
+            f(p);
+          }
+        }
+      }
+#endif
+
+      for (; i < data.size(); i++) {
+        if (set_[uint8_t(data[i])]) {
+          f(i);
+        }
+      }
+    }
+
+   protected:
+    std::array<bool, 256> set_{};
+    std::array<uint8_t, 16> low_{};
+    std::array<uint8_t, 16> high_{};
+  };
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,422 @@
+/* Gen I sprites
+ *
+ * Pokemon pictures in Gen I are compressed with a scheme of its own: the two
+ * bitplanes of a picture are stored as 2-bit pixel pairs, alternating between
+ * runs of zero pairs and literal pairs, followed by delta coding along each
+ * row and optionally by XORing one plane into the other.
+ *
+ * The decompressor follows pokered's tools/pic.py and home/uncompress.asm.
+ */
+
+#if !defined(WHATCHAMAEDIT_SPRITE_H)
+#define WHATCHAMAEDIT_SPRITE_H
+
+#include <whatchamaedit/bitmap.h>
+#include <whatchamaedit/pokemon.h>
+#include <whatchamaedit/view.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+/* MSB-first bit reader.
+ *
+ * Refills its buffer a whole 64 bit word at a time while there's at least that
+ * much input left, so reading bits is mostly just shifts. Reading past the end
+ * of the input returns zero bits and sets overrun().
+ */
+template <typename B = uint8_t>
+class bits {
+ public:
+  bits(const std::basic_string_view<B> data) : data_{data} { refill(); }
+
+  /* read @n bits, with 0 < @n <= 32. */
+  uint32_t read(const unsigned n) {
+    if (count_ < n) {
+      refill();
+    }
+
+    const uint32_t v = uint32_t(buffer_ >> (64 - n));
+    buffer_ <<= n;
+    count_ -= n;
+    read_ += n;
+
+    return v;
+  }
+
+  bool bit(void) { return read(1); }
+
+  bool overrun(void) const { return read_ > data_.size() * 8; }
+
+  /* number of bytes that have been read, including partially read ones. */
+  std::size_t consumed(void) const { return (read_ + 7) / 8; }
+
+ protected:
+  std::basic_string_view<B> data_;
+  std::size_t pos_ = 0;
+  uint64_t buffer_ = 0;
+  unsigned count_ = 0;
+  std::size_t read_ = 0;
+
+  void refill(void) {
+    if (pos_ + 8 <= data_.size()) {
+      const auto *p = data_.data() + pos_;
+      uint64_t w = 0;
+      for (int i = 0; i < 8; i++) {
+        w = w << 8 | uint8_t(p[i]);
+      }
+
+      /* this may load some bits of the next byte into the bottom of the buffer
+       * without counting them; that's fine, as the next refill will OR the
+       * same bits into the same place. */
+      buffer_ |= w >> count_;
+      pos_ += (63 - count_) >> 3;
+      count_ |= 56;
+    } else {
+      while (count_ <= 56) {
+        const uint64_t b = pos_ < data_.size() ? uint8_t(data_[pos_]) : 0;
+        buffer_ |= b << (56 - count_);
+        pos_++;
+        count_ += 8;
+      }
+    }
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+namespace pokemon {
+namespace bgry {
+namespace location {
+static constexpr std::size_t pokedexOrder = 0x41024;  // PokedexOrder, 10:5024
+static constexpr std::size_t pokedexOrderCount = 190;
+}  // namespace location
+
+/* a decompressed picture.
+ *
+ * Both bitplanes are stored in column-major order, just like the game's own
+ * sprite buffers: all rows of the first 8 pixel wide column, then all rows of
+ * the next, and so on.
+ */
+class pic {
+ public:
+  /* decompress a picture.
+   *
+   * @v a view starting at the compressed picture.
+   *
+   * Returns nothing if the data doesn't decompress cleanly.
+   */
+  template <typename view>
+  static std::optional<pic> decompress(const view &v) {
+    gameboy::rom::bits in{v.raw()};
+    pic p{};
+
+    p.height_ = in.read(4);
+    p.width_ = in.read(4);
+
+    if (p.width_ == 0 || p.height_ == 0) {
+      return {};
+    }
+
+    const std::size_t size = p.width_ * p.height_ * 8;
+    std::vector<uint8_t> planes[2]{};
+
+    const unsigned r1 = in.bit();
+    const unsigned r2 = r1 ^ 1;
+
+    if (!p.fill(in, planes[r1])) {
+      return {};
+    }
+
+    unsigned mode = in.bit();
+    if (mode) {
+      mode += in.bit();
+    }
+
+    if (!p.fill(in, planes[r2]) || in.overrun()) {
+      return {};
+    }
+
+    switch (mode) {
+      case 0:
+        p.delta(planes[0]);
+        p.delta(planes[1]);
+        break;
+      case 1:
+        p.delta(planes[r1]);
+        exclusive(planes[r1], planes[r2]);
+        break;
+      case 2:
+        p.delta(planes[r2]);
+        p.delta(planes[r1]);
+        exclusive(planes[r1], planes[r2]);
+        break;
+    }
+
+    p.low_ = std::move(planes[0]);
+    p.high_ = std::move(planes[1]);
+    p.size_ = in.consumed();
+
+    if (p.low_.size() != size || p.high_.size() != size) {
+      return {};
+    }
+
+    return p;
+  }
+
+  /* width in tiles */
+  std::size_t width(void) const { return width_; }
+
+  /* height in tiles */
+  std::size_t height(void) const { return height_; }
+
+  /* size of the compressed data in bytes. */
+  std::size_t size(void) const { return size_; }
+
+  /* the picture as GameBoy 2bpp tiles, in column-major order. */
+  std::vector<uint8_t> tiles(void) const {
+    std::vector<uint8_t> rv{};
+    rv.reserve(low_.size() * 2);
+
+    for (std::size_t i = 0; i < low_.size(); i++) {
+      rv.push_back(low_[i]);
+      rv.push_back(high_[i]);
+    }
+
+    return rv;
+  }
+
+  graphics::bitmap bitmap(void) const {
+    const std::size_t rows = height_ * 8;
+    graphics::bitmap rv{width_ * 8, rows};
+
+    for (std::size_t c = 0; c < width_; c++) {
+      for (std::size_t y = 0; y < rows; y++) {
+        const uint8_t lo = low_[c * rows + y];
+        const uint8_t hi = high_[c * rows + y];
+
+        for (std::size_t x = 0; x < 8; x++) {
+          const unsigned b = 7 - x;
+          rv(c * 8 + x, y) = ((lo >> b) & 1) | ((hi >> b) & 1) << 1;
+        }
+      }
+    }
+
+    return rv;
+  }
+
+ protected:
+  std::size_t width_ = 0;
+  std::size_t height_ = 0;
+  std::size_t size_ = 0;
+  std::vector<uint8_t> low_{};
+  std::vector<uint8_t> high_{};
+
+  /* read one bitplane's worth of pixel pairs and put them into place.
+   *
+   * The compressed stream goes down each 2 pixel wide column of the picture,
+   * so we collect four columns' worth of pairs and then interleave them into
+   * bytes.
+   */
+  template <typename I>
+  bool fill(I &in, std::vector<uint8_t> &plane) const {
+    const std::size_t rows = height_ * 8;
+    const std::size_t size = width_ * rows * 4;
+
+    std::vector<uint8_t> pairs{};
+    pairs.reserve(size);
+
+    bool rle = !in.bit();
+
+    while (pairs.size() < size) {
+      if (rle) {
+        unsigned i = 0;
+        while (in.bit()) {
+          if (++i >= 16 || in.overrun()) {
+            return false;
+          }
+        }
+
+        const std::size_t n = (std::size_t(2) << i) - 1 + in.read(i + 1);
+        if (pairs.size() + n > size) {
+          return false;
+        }
+
+        pairs.insert(pairs.end(), n, 0);
+      } else {
+        while (pairs.size() < size) {
+          const uint8_t pair = in.read(2);
+          if (pair == 0) {
+            break;
+          }
+          pairs.push_back(pair);
+        }
+      }
+
+      if (in.overrun()) {
+        return false;
+      }
+
+      rle = !rle;
+    }
+
+    plane.assign(width_ * rows, 0);
+
+    for (std::size_t c = 0; c < width_; c++) {
+      for (std::size_t y = 0; y < rows; y++) {
+        const std::size_t at = 4 * c * rows + y;
+
+        plane[c * rows + y] = pairs[at] << 6 | pairs[at + rows] << 4 |
+                              pairs[at + 2 * rows] << 2 | pairs[at + 3 * rows];
+      }
+    }
+
+    return true;
+  }
+
+  /* undo the delta coding along each row of a bitplane. */
+  void delta(std::vector<uint8_t> &plane) const {
+    static constexpr uint8_t table[2][16]{
+        {0x0, 0x1, 0x3, 0x2, 0x7, 0x6, 0x4, 0x5, 0xf, 0xe, 0xc, 0xd, 0x8, 0x9,
+         0xb, 0xa},
+        {0xf, 0xe, 0xc, 0xd, 0x8, 0x9, 0xb, 0xa, 0x0, 0x1, 0x3, 0x2, 0x7, 0x6,
+         0x4, 0x5},
+    };
+
+    const std::size_t rows = height_ * 8;
+
+    for (std::size_t y = 0; y < rows; y++) {
+      unsigned bit = 0;
+
+      for (std::size_t c = 0; c < width_; c++) {
+        uint8_t &b = plane[c * rows + y];
+
+        const uint8_t hi = table[bit][b >> 4];
+        bit = hi & 1;
+        const uint8_t lo = table[bit][b & 0xf];
+        bit = lo & 1;
+
+        b = hi << 4 | lo;
+      }
+    }
+  }
+
+  static void exclusive(const std::vector<uint8_t> &from,
+                        std::vector<uint8_t> &into) {
+    for (std::size_t i = 0; i < into.size() && i < from.size(); i++) {
+      into[i] ^= from[i];
+    }
+  }
+};
+
+/* all front and back sprites of a ROM.
+ *
+ * The picture pointers are in the base stats, but the bank the pictures are
+ * in depends on the Pokemon's internal index, which is why we also need the
+ * Pokedex order table.
+ */
+class sprites {
+ public:
+  std::vector<std::optional<pic>> front;
+  std::vector<std::optional<pic>> back;
+
+  /** @constructor
+   *
+   * @rom the ROM to extract sprites from; needs to be a whatchamaedit::rom::gb
+   * or similar.
+   * @threads the number of threads to decompress with; 0 means one per
+   * hardware thread.
+   */
+  template <typename R>
+  sprites(const R &rom, std::size_t threads = 0) {
+    using view = typename R::view;
+    using pointer = typename R::pointer;
+
+    const view v{rom};
+    const auto &stats = rom.tables().stats;
+    const auto internal = indices(v, stats.size());
+
+    front.resize(stats.size());
+    back.resize(stats.size());
+
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::atomic<std::size_t> next{0};
+    const auto work = [&]() {
+      for (std::size_t i; (i = next++) < stats.size();) {
+        const uint8_t b = bank(internal[i]);
+
+        front[i] = pic::decompress(v.from(pointer{b, stats.frontSprite[i]}));
+        back[i] = pic::decompress(v.from(pointer{b, stats.backSprite[i]}));
+      }
+    };
+
+    std::vector<std::thread> pool{};
+    for (std::size_t t = 1; t < threads; t++) {
+      pool.emplace_back(work);
+    }
+
+    work();
+
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+
+  /* the bank a Pokemon's pictures are in, by internal index.
+   *
+   * See UncompressMonSprite in the pokered disassembly.
+   */
+  static constexpr uint8_t bank(const uint8_t internal) {
+    return internal == 0x15   ? 0x01  // MEW
+           : internal == 0xb6 ? 0x0b  // FOSSIL_KABUTOPS
+           : internal < 0x1f  ? 0x09  // up to TANGELA
+           : internal < 0x4a  ? 0x0a  // up to MOLTRES
+           : internal < 0x74  ? 0x0b  // up to BEEDRILL + 1
+           : internal < 0x99  ? 0x0c  // up to STARMIE
+                              : 0x0d;
+  }
+
+  /* lay out all sprites on a sheet, fronts first, then backs. */
+  graphics::bitmap sheet(const std::size_t columns = 16) const {
+    std::vector<graphics::bitmap> b{};
+
+    for (const auto *s : {&front, &back}) {
+      for (const auto &p : *s) {
+        b.push_back(p ? p->bitmap() : graphics::bitmap{56, 56});
+      }
+    }
+
+    return graphics::bitmap::sheet(b, columns);
+  }
+
+ protected:
+  /* map Pokedex numbers to internal indices. */
+  template <typename view>
+  static std::vector<uint8_t> indices(const view &v, const std::size_t count) {
+    std::vector<uint8_t> rv(count, 0);
+    const auto order =
+        v.from(location::pokedexOrder).limit(location::pokedexOrderCount).raw();
+
+    for (std::size_t i = 0; i < order.size(); i++) {
+      const std::size_t dex = order[i];
+      if (dex > 0 && dex <= count && rv[dex - 1] == 0) {
+        rv[dex - 1] = uint8_t(i + 1);
+      }
+    }
+
+    return rv;
+  }
+};
+}  // namespace bgry
+}  // namespace pokemon
+
+#endif
@@ -4,61 +4,88 @@
 #include <whatchamaedit/character-map.h>
 #include <whatchamaedit/view.h>
 
+#include <algorithm>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace gameboy {
 namespace rom {
-template <typename B = uint8_t, typename W = uint16_t>
-class string : gameboy::rom::view<B, W> {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class string : gameboy::rom::view<B, W, K> {
  public:
-  using pointer = gameboy::rom::pointer<B, W>;
-  using view = gameboy::rom::view<B, W>;
+  using pointer = gameboy::rom::pointer<K, W>;
+  using view = gameboy::rom::view<B, W, K>;
 
-  string(view v) : view{v} {}
+  /** @constructor
+   *
+   * @v where the string starts.
+   * @language what the text is in; it needs to outlive the string, which the
+   * ones in text::languages do.
+   */
+  string(view v, const text::language &language = text::languages::english)
+      : view{v}, language_{&language} {}
 
   const std::string translated(void) const {
     std::string rv{};
+    translate(rv);
+    return rv;
+  }
 
-    for (const auto b : *this) {
-      if (b == text::pokemon::bgry::end) {
-        break;
-      }
-
-      if (text::pokemon::bgry::english.count(b) == 0) {
-        break;
-      }
+  /* like translated(), but appends the text to @out instead; returns how
+   * many bytes were appended. */
+  std::size_t translate(std::string &out) const {
+    const auto &d = language_->glyphs();
+    const uint8_t end = language_->end();
+    const std::size_t before = out.size();
 
-      const std::string_view v = text::pokemon::bgry::english.at(b);
+    for (const auto b : view::raw()) {
+      const std::string_view v = d[b];
 
-      if (v.empty()) {
+      if (b == end || v.empty()) {
         break;
       }
 
-      rv += v;
+      out += v;
     }
 
-    return rv;
+    return out.size() - before;
   }
 
   const std::set<pointer> scan(void) const {
+    return scan([](const pointer) { return true; });
+  }
+
+  /* like scan(), but bytes for which @keep returns false are never part of a
+   * string, e.g. to skip regions that are known not to hold any text. */
+  template <typename P>
+  const std::set<pointer> scan(P keep) const {
     std::set<pointer> rv{};
+    scan(keep, [&rv](const pointer p) { rv.insert(rv.end(), p); });
+    return rv;
+  }
+
+  /* like scan(), but calls @found with where each string starts as soon as
+   * it's been found, in address order, instead of collecting them. */
+  template <typename P, typename F>
+  void scan(P keep, F found) const {
     pointer start = view::start_, cur = view::start_;
 
     std::size_t length = 0, text = 0;
 
     for (const auto b : *this) {
-      if (b == 0 || text::pokemon::bgry::english.count(b) == 0 ||
-          b == text::pokemon::bgry::end) {
+      if (!keep(cur) || language_->ends(b)) {
         if (text > 4 && text * 12 / 11 < length) {
-          rv.insert(start);
+          found(start);
         }
 
         length = 0;
         text = 0;
       } else {
         length++;
-        if (text::pokemon::bgry::isText(b)) {
+        if (language_->text(b)) {
           text++;
         }
       }
@@ -69,8 +96,210 @@ class string : gameboy::rom::view<B, W> {
         start = cur;
       }
     }
+  }
 
-    return rv;
+ protected:
+  const text::language *language_;
+};
+
+/* decoded strings, with all of their text in a single block.
+ *
+ * Each string is a record of where it is in the ROM and where its text is in
+ * the block, and records are kept in address order in a flat array. Adding a
+ * string only ever appends to the block and the array, and looking one up is
+ * a binary search, so neither allocates anything per string; entries hand out
+ * views into the block, which stay valid until the table is next changed.
+ */
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class stringTable {
+ public:
+  using pointer = gameboy::rom::pointer<K, W>;
+  using view = gameboy::rom::view<B, W, K>;
+  using entry = std::pair<pointer, std::string_view>;
+
+  stringTable(const text::language &language = text::languages::english)
+      : language_{&language} {}
+
+  /* what the strings' text is in. */
+  const text::language &language(void) const { return *language_; }
+
+  /* decode the string at the start of @v and add it.
+   *
+   * Strings need to be added in address order, which is the order scans find
+   * them in.
+   */
+  void add(const view &v) {
+    const std::size_t offset = text_.size();
+    const std::size_t length =
+        string<B, W, K>{v, *language_}.translate(text_);
+
+    records_.push_back({v.startPtr(), uint32_t(offset), uint32_t(length)});
+  }
+
+  /* add a string that's already been decoded, e.g. from a snapshot; like
+   * with the other add(), strings need to be added in address order. */
+  void add(const pointer p, const std::string_view text) {
+    records_.push_back({p, uint32_t(text_.size()), uint32_t(text.size())});
+    text_ += text;
+  }
+
+  std::size_t size(void) const { return records_.size(); }
+
+  bool empty(void) const { return records_.empty(); }
+
+  entry operator[](const std::size_t i) const {
+    const auto &r = records_[i];
+    return {r.at, std::string_view{text_}.substr(r.offset, r.length)};
+  }
+
+  /* rescan the strings around a change in @rom.
+   *
+   * @rom a view of the whole ROM.
+   * @start where the change starts, as a linear address.
+   * @end one past where the change ends.
+   *
+   * The change is extended to the bytes that end strings on either side of
+   * it, and only that part of the ROM is scanned again; the strings that were
+   * there are replaced with what was found. If the table was made with a
+   * full scan, it's the same as another full scan would be afterwards.
+   *
+   * A scan never looks past a byte that the language ends strings with, so a
+   * change can only affect the strings in the run of other bytes around it.
+   */
+  void update(const view &rom, std::size_t start, std::size_t end) {
+    using string = gameboy::rom::string<B, W, K>;
+    const auto data = rom.raw();
+
+    end = std::min(end, data.size());
+
+    if (start >= end) {
+      return;
+    }
+
+    while (start > 0 && !language_->ends(data[start - 1])) {
+      start--;
+    }
+    while (end < data.size() && !language_->ends(data[end])) {
+      end++;
+    }
+    if (end < data.size()) {
+      end++;
+    }
+
+    stringTable t{*language_};
+    string{rom.from(pointer{start}).to(pointer{end - 1}), *language_}.scan(
+        [](const pointer) { return true; },
+        [&t, &rom](const pointer p) { t.add(rom.from(p)); });
+
+    replace(pointer{start}, pointer{end}, t);
+  }
+
+  /* replace the strings that start between @start and just before @end with
+   * those in @t, which all need to start in that range as well. */
+  void replace(const pointer start, const pointer end, const stringTable &t) {
+    const auto first = find(start), last = find(end);
+
+    for (auto it = first; it != last; it++) {
+      unused_ += it->length;
+    }
+
+    const auto at = records_.erase(first, last);
+    const std::size_t offset = text_.size();
+    std::vector<record> added{t.records_};
+
+    for (auto &r : added) {
+      r.offset += offset;
+    }
+
+    text_ += t.text_;
+    records_.insert(at, added.begin(), added.end());
+
+    /* text that's been replaced is only ever appended to, so compact once
+     * most of the block is no longer used. */
+    if (unused_ > text_.size() / 2) {
+      compact();
+    }
+  }
+
+  /* the text of the string at @p, if there is one that starts there. */
+  std::optional<std::string_view> at(const pointer p) const {
+    const auto it = find(p);
+
+    if (it == records_.end() || !(it->at == p)) {
+      return {};
+    }
+
+    return (*this)[it - records_.begin()].second;
+  }
+
+  /* the block all of the text is in; after update(), this can also have the
+   * text of strings that have since been replaced. */
+  const std::string &text(void) const { return text_; }
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const entry *;
+    using reference = entry;
+
+    iterator(const stringTable &t, const std::size_t i) : table_{t}, i_{i} {}
+
+    entry operator*(void) const { return table_[i_]; }
+
+    iterator &operator++(void) {
+      i_++;
+      return *this;
+    }
+
+    bool operator!=(const iterator &b) const { return i_ != b.i_; }
+
+   protected:
+    const stringTable &table_;
+    std::size_t i_;
+  };
+
+  iterator begin(void) const { return {*this, 0}; }
+  iterator end(void) const { return {*this, records_.size()}; }
+
+ protected:
+  struct record {
+    pointer at;
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  const text::language *language_;
+  std::string text_{};
+  std::vector<record> records_{};
+  std::size_t unused_{0};
+
+  /* the first record that starts at or after @p. */
+  typename std::vector<record>::iterator find(const pointer p) {
+    return std::lower_bound(
+        records_.begin(), records_.end(), p,
+        [](const record &r, const pointer q) { return r.at < q; });
+  }
+
+  typename std::vector<record>::const_iterator find(const pointer p) const {
+    return std::lower_bound(
+        records_.begin(), records_.end(), p,
+        [](const record &r, const pointer q) { return r.at < q; });
+  }
+
+  void compact(void) {
+    std::string text{};
+    text.reserve(text_.size() - unused_);
+
+    for (auto &r : records_) {
+      const std::size_t offset = text.size();
+      text.append(text_, r.offset, r.length);
+      r.offset = uint32_t(offset);
+    }
+
+    text_.swap(text);
+    unused_ = 0;
   }
 };
 }  // namespace rom
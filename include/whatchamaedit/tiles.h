@@ -0,0 +1,153 @@
+/* 2bpp tiles
+ *
+ * GameBoy graphics are made of 8x8 pixel tiles with two bits per pixel, stored
+ * as 16 bytes: two bytes per row, the first one holding the low bit of each of
+ * the row's pixels and the second one the high bit, with the leftmost pixel in
+ * the most significant bit.
+ *
+ * Decoding a row means interleaving the bits of those two bytes into eight
+ * pixels. With SSE2, which every x86-64 CPU has, a whole tile is decoded at a
+ * time: each byte is unpacked into eight lanes, which are masked with one bit
+ * each and compared, so a row's two bytes turn into sixteen lanes of 0 or -1
+ * that only need to be weighted and added up. Elsewhere it's two lookups per
+ * row in a table of pre-spread bytes.
+ */
+
+#if !defined(WHATCHAMAEDIT_TILES_H)
+#define WHATCHAMAEDIT_TILES_H
+
+#include <whatchamaedit/bitmap.h>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace graphics {
+namespace tiles {
+/* size of a tile in bytes. */
+static constexpr std::size_t size = 16;
+
+/* spread the bits of @b over the bytes of a word, so that byte n of the
+ * result holds bit 7 - n of @b. */
+static constexpr uint64_t spread(const uint8_t b) {
+  uint64_t rv = 0;
+
+  for (unsigned n = 0; n < 8; n++) {
+    rv |= uint64_t((b >> (7 - n)) & 1) << (n * 8);
+  }
+
+  return rv;
+}
+
+/* decode a row of a tile into eight pixels, one per byte, leftmost pixel in
+ * the lowest byte. */
+static inline uint64_t row(const uint8_t low, const uint8_t high) {
+  static constexpr auto table = [] {
+    std::array<uint64_t, 256> t{};
+    for (unsigned b = 0; b < t.size(); b++) {
+      t[b] = spread(b);
+    }
+    return t;
+  }();
+
+  return table[low] | table[high] << 1;
+}
+
+/* draw a single tile at @x, @y; the tile has to fit into @out. */
+template <typename B>
+static void draw(const B *tile, bitmap &out, const std::size_t x,
+                 const std::size_t y) {
+#if defined(__SSE2__)
+  static_assert(sizeof(B) == 1, "tiles need to be made of bytes");
+
+  /* lanes 0 - 7 hold a row's low byte, 8 - 15 its high byte; the masks pick
+   * the bit for each pixel, and the weights are what that bit is worth. */
+  const __m128i mask = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+                                    16, 32, 64, -128);
+  const __m128i weight = _mm_set_epi8(2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1,
+                                      1, 1, 1);
+
+  const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tile));
+  const __m128i halves[2]{_mm_unpacklo_epi8(t, t), _mm_unpackhi_epi8(t, t)};
+
+  for (std::size_t h = 0; h < 2; h++) {
+    const __m128i pairs[2]{_mm_unpacklo_epi16(halves[h], halves[h]),
+                           _mm_unpackhi_epi16(halves[h], halves[h])};
+
+    for (std::size_t p = 0; p < 2; p++) {
+      const __m128i rows[2]{_mm_unpacklo_epi32(pairs[p], pairs[p]),
+                            _mm_unpackhi_epi32(pairs[p], pairs[p])};
+
+      for (std::size_t r = 0; r < 2; r++) {
+        const __m128i bits = _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_and_si128(rows[r], mask), mask), weight);
+        const __m128i pixels = _mm_or_si128(bits, _mm_srli_si128(bits, 8));
+
+        _mm_storel_epi64(
+            reinterpret_cast<__m128i *>(out.row(y + h * 4 + p * 2 + r) + x),
+            pixels);
+      }
+    }
+  }
+#else
+  for (std::size_t r = 0; r < 8; r++) {
+    const uint64_t pixels = row(uint8_t(tile[r * 2]), uint8_t(tile[r * 2 + 1]));
+    uint8_t *p = out.row(y + r) + x;
+
+    for (unsigned n = 0; n < 8; n++) {
+      p[n] = uint8_t(pixels >> (n * 8));
+    }
+  }
+#endif
+}
+
+/* lay out all whole tiles in @data in rows of @columns tiles. */
+template <typename B>
+static bitmap sheet(const std::basic_string_view<B> data,
+                    const std::size_t columns = 16) {
+  const std::size_t count = data.size() / size;
+  const std::size_t rows = (count + columns - 1) / columns;
+  bitmap rv{columns * 8, rows * 8};
+
+  for (std::size_t i = 0; i < count; i++) {
+    draw(data.data() + i * size, rv, (i % columns) * 8, (i / columns) * 8);
+  }
+
+  return rv;
+}
+
+/* render a view as tiles.
+ *
+ * The view should be typed as dt_tiles; anything after the last whole tile is
+ * ignored either way.
+ */
+template <typename view>
+static bitmap sheet(const view &v, const std::size_t columns = 16) {
+  return sheet(v.raw(), columns);
+}
+
+/* render every bank of a ROM as its own tile sheet, and put those side by
+ * side, @perRow banks to a row. */
+template <typename view>
+static bitmap banks(const view &rom, const std::size_t perRow = 16) {
+  using pointer = typename view::pointer;
+
+  std::vector<bitmap> b{};
+
+  for (std::size_t n = 0; n < rom.banks(); n++) {
+    const pointer start{n * pointer::bankSize()};
+
+    b.push_back(sheet(rom.from(start).toBankEnd().asTiles()));
+  }
+
+  return bitmap::sheet(b, perRow);
+}
+}  // namespace tiles
+}  // namespace graphics
+
+#endif
@@ -0,0 +1,329 @@
+/* Translation files
+ *
+ * Exports the strings of a ROM for translators, and reads edited files back
+ * into a batch, so they are checked and applied like any other batch of text
+ * edits. Two formats are supported; gettext PO, for translation tools:
+ *
+ *     #. budget: 24
+ *     msgctxt "0x0041c7"
+ *     msgid "POKé BALL"
+ *     msgstr ""
+ *
+ * and CSV, for spreadsheets:
+ *
+ *     address,budget,text,translation
+ *     0x0041c7,24,POKé BALL,
+ *
+ * The budget is how many bytes the string may take up, including its
+ * terminator. Entries without a translation, or whose translation is the text
+ * that's already there, are left alone on import, so a file can be exported
+ * and imported again as it is.
+ */
+
+#if !defined(WHATCHAMAEDIT_TRANSLATION_H)
+#define WHATCHAMAEDIT_TRANSLATION_H
+
+#include <whatchamaedit/batch.h>
+#include <whatchamaedit/string.h>
+
+#include <iomanip>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class translations {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using batch = gameboy::rom::batch<B, W, K>;
+  using stringTable = gameboy::rom::stringTable<B, W, K>;
+  using error = typename batch::error;
+
+  enum format {
+    tf_po,
+    tf_csv,
+  };
+
+  /* the format for @file, going by its extension. */
+  static std::optional<format> formatOf(const std::string &file) {
+    const auto ends = [&file](const std::string_view e) {
+      return file.size() >= e.size() &&
+             file.compare(file.size() - e.size(), e.size(), e) == 0;
+    };
+
+    if (ends(".po") || ends(".pot")) {
+      return tf_po;
+    }
+    if (ends(".csv")) {
+      return tf_csv;
+    }
+
+    return {};
+  }
+
+  /* write all of @strings, which are in @rom, to @out. */
+  static void save(std::ostream &out, const format f, const view &rom,
+                   const stringTable &strings) {
+    if (f == tf_po) {
+      out << "msgid \"\"\nmsgstr \"Content-Type: text/plain; "
+             "charset=UTF-8\\n\"\n";
+    } else {
+      out << "address,budget,text,translation\n";
+    }
+
+    for (const auto &s : strings) {
+      const std::size_t budget =
+          batch::space(rom, s.first, strings.language());
+      std::ostringstream address{};
+      address << "0x" << std::hex << std::setw(6) << std::setfill('0')
+              << s.first.linear();
+
+      if (f == tf_po) {
+        out << "\n#. budget: " << budget << "\nmsgctxt \"" << address.str()
+            << "\"\nmsgid \"" << po(s.second) << "\"\nmsgstr \"\"\n";
+      } else {
+        out << address.str() << "," << budget << "," << csv(s.second)
+            << ",\n";
+      }
+    }
+  }
+
+  /* read a file in format @f and add every entry with a translation to
+   * @edits.
+   *
+   * Returns false if there were syntax errors, which are also added to
+   * errors(); entries that could be read are added either way.
+   */
+  bool load(std::istream &in, const format f, batch &edits) {
+    return f == tf_po ? loadPO(in, edits) : loadCSV(in, edits);
+  }
+
+  const std::vector<error> &errors(void) const { return errors_; }
+
+ protected:
+  std::vector<error> errors_{};
+
+  static std::string po(const std::string_view s) {
+    std::string rv{};
+
+    for (const char c : s) {
+      switch (c) {
+        case '"':
+          rv += "\\\"";
+          break;
+        case '\\':
+          rv += "\\\\";
+          break;
+        case '\n':
+          rv += "\\n";
+          break;
+        case '\t':
+          rv += "\\t";
+          break;
+        default:
+          rv += c;
+      }
+    }
+
+    return rv;
+  }
+
+  static std::string csv(const std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos &&
+        (s.empty() || (s.front() != ' ' && s.back() != ' '))) {
+      return std::string(s);
+    }
+
+    std::string rv{"\""};
+
+    for (const char c : s) {
+      rv += c;
+      if (c == '"') {
+        rv += c;
+      }
+    }
+
+    return rv + "\"";
+  }
+
+  /* the text of a quoted PO string, without the quotes. */
+  static std::optional<std::string> unquote(const std::string_view s) {
+    if (s.size() < 2 || s.front() != '"' || s.back() != '"') {
+      return {};
+    }
+
+    std::string rv{};
+
+    for (std::size_t i = 1; i + 1 < s.size(); i++) {
+      if (s[i] != '\\') {
+        rv += s[i];
+        continue;
+      }
+
+      if (++i + 1 >= s.size()) {
+        return {};
+      }
+
+      switch (s[i]) {
+        case 'n':
+          rv += '\n';
+          break;
+        case 't':
+          rv += '\t';
+          break;
+        default:
+          rv += s[i];
+      }
+    }
+
+    return rv;
+  }
+
+  bool loadPO(std::istream &in, batch &edits) {
+    struct {
+      std::size_t line = 0;
+      std::string context, id, str;
+    } entry{};
+    std::string *last = nullptr;
+    std::size_t line = 0;
+    bool ok = true;
+
+    const auto done = [&edits, &entry]() {
+      if (!entry.context.empty() && !entry.str.empty() &&
+          entry.str != entry.id) {
+        edits.add(entry.context, entry.str, entry.line);
+      }
+
+      entry = {};
+    };
+
+    for (std::string l; std::getline(in, l);) {
+      line++;
+
+      if (!l.empty() && l.back() == '\r') {
+        l.pop_back();
+      }
+
+      const auto start = l.find_first_not_of(" \t");
+      if (start == std::string::npos) {
+        done();
+        last = nullptr;
+        continue;
+      }
+
+      if (l[start] == '#') {
+        continue;
+      }
+
+      l.erase(l.find_last_not_of(" \t") + 1);
+
+      const auto sep = l.find_first_of(" \t", start);
+      const std::string keyword = l.substr(start, sep - start);
+      const auto value =
+          l[start] == '"' ? start : l.find_first_not_of(" \t", sep);
+      const auto text = unquote(value == std::string::npos
+                                    ? std::string_view{}
+                                    : std::string_view{l}.substr(value));
+
+      if (!text) {
+        errors_.push_back({line, "malformed string"});
+        ok = false;
+        continue;
+      }
+
+      if (l[start] == '"') {
+        if (last == nullptr) {
+          errors_.push_back({line, "string continues nothing"});
+          ok = false;
+        } else {
+          *last += *text;
+        }
+      } else if (keyword == "msgctxt") {
+        done();
+        entry.line = line;
+        entry.context = *text;
+        last = &entry.context;
+      } else if (keyword == "msgid") {
+        entry.id = *text;
+        last = &entry.id;
+      } else if (keyword == "msgstr") {
+        entry.str = *text;
+        last = &entry.str;
+      } else {
+        errors_.push_back({line, "unknown keyword '" + keyword + "'"});
+        ok = false;
+      }
+    }
+
+    done();
+
+    return ok;
+  }
+
+  bool loadCSV(std::istream &in, batch &edits) {
+    std::size_t line = 0;
+    bool ok = true;
+
+    for (std::string l; std::getline(in, l);) {
+      const std::size_t first = ++line;
+      std::vector<std::string> fields{""};
+      bool quoted = false;
+
+      /* quoted fields can span lines, so keep reading until the row ends
+       * outside of quotes. */
+      for (bool more = true; more;) {
+        if (!l.empty() && l.back() == '\r') {
+          l.pop_back();
+        }
+
+        for (std::size_t i = 0; i < l.size(); i++) {
+          const char c = l[i];
+
+          if (quoted && c == '"' && i + 1 < l.size() && l[i + 1] == '"') {
+            fields.back() += c;
+            i++;
+          } else if (c == '"') {
+            quoted = !quoted;
+          } else if (c == ',' && !quoted) {
+            fields.emplace_back();
+          } else {
+            fields.back() += c;
+          }
+        }
+
+        more = quoted && std::getline(in, l);
+        if (more) {
+          line++;
+          fields.back() += '\n';
+        }
+      }
+
+      if (quoted || fields.size() != 4) {
+        errors_.push_back({first, "expected address, budget, text and "
+                                  "translation"});
+        ok = false;
+        continue;
+      }
+
+      if (first == 1 && fields[0] == "address") {
+        continue;
+      }
+
+      if (!fields[3].empty() && fields[3] != fields[2]) {
+        edits.add(fields[0], fields[3], first);
+      }
+    }
+
+    return ok;
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
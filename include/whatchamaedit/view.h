@@ -4,13 +4,18 @@
 #include <whatchamaedit/pointer.h>
 
 #include <array>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <optional>
 #include <set>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <tuple>
 
 namespace gameboy {
 enum type {
@@ -22,6 +27,7 @@ enum type {
   dt_word,
   dt_words,
   dt_text,
+  dt_tiles,
 };
 
 enum endianness {
@@ -65,11 +71,132 @@ class annotations {
     *this = *this | b;
     return *this;
   }
+
+  /* a small number standing in for a set of annotations.
+   *
+   * Views only keep one of these, rather than the annotations themselves,
+   * which keeps them down to a few machine words. The type and endianness are
+   * encoded in the id directly, as there are only a few dozen combinations of
+   * them, so reading those back is just arithmetic; only labels need a table.
+   */
+  using id = uint16_t;
+
+  /* the number of combinations of type and endianness, including neither;
+   * this relies on dt_tiles being the last type. */
+  static constexpr id kinds = (dt_tiles + 2) * 3;
+
+  /* how many distinct labels there can be. */
+  static constexpr std::size_t capacity = 0x10000 / kinds;
+
+  /* the id for these annotations.
+   *
+   * Labels are added to a table the first time they are seen and looked up
+   * from then on. The table is shared by all views rather than kept per
+   * image, since views know nothing about the image they are over; labels are
+   * almost always string literals anyway, so there are only ever a few. The
+   * table keeps its own copy of every label, so they needn't outlive the view.
+   *
+   * Throws std::length_error if a new label doesn't fit into the table.
+   * Without a label, there's no table to look at, so that can be done at
+   * compile time.
+   */
+  constexpr id intern(void) const {
+    const id kind =
+        (type ? *type + 1 : 0) * 3 + (endianness ? *endianness + 1 : 0);
+
+    return kind + kinds * (label ? number(*label) : 0);
+  }
+
+  /* the annotations for an id that intern() returned; again, that's only a
+   * compile time thing if there's no label. */
+  static constexpr annotations at(const id i) {
+    annotations a = unlabelled(i);
+
+    if (i >= kinds) {
+      a.label = shared().labels[i / kinds];
+    }
+
+    return a;
+  }
+
+  /* like at(), but without the label, which is never needed to read or check
+   * data and would be the only part that needs a table lookup. */
+  static constexpr annotations unlabelled(const id i) {
+    const id kind = i % kinds;
+    annotations a{};
+
+    if (kind / 3 > 0) {
+      a.type = gameboy::type(kind / 3 - 1);
+    }
+    if (kind % 3 > 0) {
+      a.endianness = gameboy::endianness(kind % 3 - 1);
+    }
+
+    return a;
+  }
+
+ protected:
+  struct table {
+    std::mutex lock;
+    std::map<std::string_view, id> numbers;
+    std::array<std::string_view, capacity> labels;
+    /* where the labels actually live; deques don't move their elements when
+     * they grow, so the views above stay valid. */
+    std::deque<std::string> storage;
+  };
+
+  static table &shared(void) {
+    static table t{};
+    return t;
+  }
+
+  /* the label's number in the table, starting at 1. */
+  static id number(const std::string_view label) {
+    /* labels are nearly always string literals, so remembering the recently
+     * used ones by where they are saves taking the lock for all but the first
+     * time a thread sees each of them. The address only picks the slot; the
+     * label itself is still compared, as it may be somewhere else by now. */
+    struct entry {
+      std::string_view label;
+      id number;
+    };
+    thread_local std::array<entry, 64> recent{};
+
+    auto &r = recent[std::uintptr_t(label.data()) / 8 % recent.size()];
+    if (r.number != 0 && r.label == label) {
+      return r.number;
+    }
+
+    auto &t = shared();
+    std::lock_guard<std::mutex> lock(t.lock);
+    auto it = t.numbers.find(label);
+
+    if (it == t.numbers.end()) {
+      const id n = t.numbers.size() + 1;
+
+      if (n >= capacity) {
+        throw std::length_error("too many distinct view labels");
+      }
+
+      t.labels[n] = t.storage.emplace_back(label);
+      it = t.numbers.insert({t.labels[n], n}).first;
+    }
+
+    r = {t.labels[it->second], it->second};
+
+    return r.number;
+  }
 };
 
+namespace container {
+template <typename view, typename thing>
+class sequence;
+}  // namespace container
+
 namespace generic {
 template <typename B = int8_t, typename W = int16_t,
-          typename bytes = typename std::basic_string_view<B>>
+          typename bytes = typename std::basic_string_view<B>,
+          typename K = B>
 class view;
 
 template <std::size_t count, typename B = uint8_t, typename W = uint16_t>
@@ -91,12 +218,20 @@ class blank {
   static constexpr std::array<B, count> data_{};
 };
 
-template <typename B, typename W, typename bytes>
+/* a window into a ROM image.
+ *
+ * @B the type of a byte in the image.
+ * @W the type of a word, and of a bank offset.
+ * @K the type of a bank number; this is B by default, which is fine for up to
+ * 256 banks, but MBC5 ROMs can have up to 512.
+ */
+template <typename B, typename W, typename bytes, typename K>
 class view {
  public:
   using annotations = annotations<B, W>;
-  using pointer = gameboy::rom::pointer<B, W>;
-  using lazy = gameboy::rom::lazy<view, B, W>;
+  using pointer = gameboy::rom::pointer<K, W>;
+  using lazy = gameboy::rom::lazy<view, K, W>;
+  using bank = K;
 
   using subviews = std::set<view *>;
   using lazies = std::set<lazy *>;
@@ -106,27 +241,31 @@ class view {
         start_{0},
         end_{data.size() - 1},
         cur_{0},
-        annotations_{} {}
+        annotations_{0} {}
 
   constexpr view(const bytes data, const pointer start)
       : data_{data},
         start_{start},
         end_{start.bank(), W(start.bankSize() - 1)},
         cur_{start},
-        annotations_{} {}
+        annotations_{0} {}
 
   constexpr view(const bytes data, const pointer start, const pointer end)
-      : data_{data}, start_{start}, end_{end}, cur_{start}, annotations_{} {}
+      : data_{data}, start_{start}, end_{end}, cur_{start}, annotations_{0} {}
 
   // this is the full constructor used by the verbose constructors
   constexpr view(const view parent, const pointer start, const pointer end,
-                 const annotations annotations)
+                 const typename annotations::id annotations)
       : data_{parent.data_},
         start_{start},
         end_{end},
         cur_{start},
         annotations_{annotations} {}
 
+  constexpr view(const view parent, const pointer start, const pointer end,
+                 const annotations annotations)
+      : view{parent, start, end, annotations.intern()} {}
+
   /** "dummy" constructor, for doing things like automatically determining the
    * size of a detailed object description.
    *
@@ -134,7 +273,7 @@ class view {
    */
   template <W count = pointer::bankSize()>
   constexpr static view blank(void) {
-    return view{generic::blank<count, B, W>{}};
+    return view{generic::blank<count, B, W>{}.readonly()};
   }
 
   /** create a view as the hull of the listed views.
@@ -146,7 +285,7 @@ class view {
    * initialising the fields.
    */
   template <std::size_t N>
-  static constexpr view hull(const std::array<view, N> views) {
+  static view hull(const std::array<view, N> views) {
     view fr = views.front();
 
     pointer start = fr.start_;
@@ -162,7 +301,7 @@ class view {
     }
 
     return {fr, start, end,
-            fr.is({dt_bytes}).label("__transitive_hull").expected()};
+            fr.is({dt_bytes}).label("__transitive_hull").annotations_};
   }
 
   /** fix point for the transitive hull constructor.
@@ -213,10 +352,12 @@ class view {
   }
 
   // data type annotations
-  constexpr annotations expected(void) const { return annotations_; }
+  constexpr annotations expected(void) const {
+    return annotations::at(annotations_);
+  }
 
   constexpr view expect(const annotations a) const {
-    return view{*this, start_, end_, annotations_ | a};
+    return view{*this, start_, end_, expected() | a};
   }
 
   /* set expected data type.
@@ -227,7 +368,7 @@ class view {
    * data types.
    */
   constexpr view is(const annotations a) const {
-    annotations b = annotations_ | a;
+    const auto b = (expected() | a).intern();
 
     if (a.type) {
       switch (*a.type) {
@@ -260,7 +401,9 @@ class view {
 
   constexpr view asROMOffset(void) const { return is({dt_rom_offset}); }
 
-  constexpr view label(const std::string_view l) const { return is({l}); }
+  constexpr view asTiles(void) const { return is({dt_tiles}); }
+
+  view label(const std::string_view l) const { return is({l}); }
 
   // iterator
   class iterator : public std::iterator<std::input_iterator_tag, B> {
@@ -342,8 +485,8 @@ class view {
   }
 
   constexpr const W word(const pointer p) const {
-    if (annotations_.endianness) {
-      switch (*annotations_.endianness) {
+    if (const auto e = kind().endianness) {
+      switch (*e) {
         case e_big_endian:
           return word_be(p);
         case e_little_endian:
@@ -396,7 +539,27 @@ class view {
            checkEndianness() && checkValue();
   }
 
-  constexpr B banks(void) const { return pointer::banks(data_.size()); }
+  constexpr std::size_t banks(void) const {
+    return pointer::banks(data_.size());
+  }
+
+  constexpr std::size_t dataSize(void) const { return data_.size(); }
+
+  /* the bytes this view covers, as one contiguous block.
+   *
+   * This is checked once for the whole view, so it's the fast path for
+   * decoders that want to look at a lot of bytes. Views that reach past the end
+   * of the data are cut short.
+   */
+  constexpr bytes raw(void) const {
+    const std::size_t start = start_.linear();
+
+    if (start >= data_.size() || end_ < start_) {
+      return bytes{};
+    }
+
+    return data_.substr(start, end_.linear() - start + 1);
+  }
 
   constexpr bool within(const pointer s, const pointer e) const {
     return start_ <= s && e <= end_;
@@ -406,32 +569,19 @@ class view {
     return within(b.start_, b.end_);
   }
 
+  /* the things that follow each other from the start of this view, as many
+   * as @cnt's byte says there are.
+   *
+   * They're decoded one at a time while iterating; see container::sequence.
+   */
   template <typename V>
-  std::vector<V> repeated(const view cnt) const {
-    std::vector<V> r{};
-    pointer st = start_;
-
-    if (cnt) {
-      auto c = cnt.byte();
-
-      while (c-- > 0) {
-        V item{from(st)};
-        auto size = item.size();
-        if (item) {
-          r.push_back(item);
-        }
-        if (size <= 0) {
-          break;
-        }
-        st = st + size;
-      }
-    }
-
-    return r;
+  container::sequence<view, V> repeated(const view cnt) const {
+    return container::sequence<view, V>::counted(*this, cnt ? cnt.byte() : 0);
   }
 
+  /* the furthest any of the things in @r reach. */
   template <typename V>
-  pointer last(const std::vector<V> &r) {
+  pointer last(const container::sequence<view, V> &r) const {
     pointer l = start_;
     for (const auto &v : r) {
       if (l < v.last()) {
@@ -442,13 +592,14 @@ class view {
   }
 
   constexpr W unit(void) const {
-    if (annotations_.type) {
-      switch (*annotations_.type) {
+    if (const auto t = kind().type) {
+      switch (*t) {
         case dt_code:
         case dt_rom_bank:
         case dt_byte:
         case dt_bytes:
         case dt_text:
+        case dt_tiles:
           return 1;
         case dt_rom_offset:
         case dt_word:
@@ -469,7 +620,12 @@ class view {
   const pointer start_;
   const pointer end_;
   pointer cur_;
-  annotations annotations_;
+  typename annotations::id annotations_;
+
+  /* the annotations without the label, which is all reads and checks need. */
+  constexpr annotations kind(void) const {
+    return annotations::unlabelled(annotations_);
+  }
 
   constexpr bool checkUnitReadable(void) const {
     /* check that a full unit of data is currently readable - this requires as
@@ -486,8 +642,8 @@ class view {
     size_t minLength = 0;
     size_t maxLength = size();
 
-    if (annotations_.type) {
-      switch (*annotations_.type) {
+    if (const auto t = kind().type) {
+      switch (*t) {
         case dt_code:
           break;
         case dt_rom_bank:
@@ -509,6 +665,12 @@ class view {
         case dt_text:
           minLength = 0;
           break;
+        case dt_tiles:
+          /* 2bpp tiles are 16 bytes each, and only whole tiles make sense. */
+          if (size() % 16 != 0) {
+            return false;
+          }
+          break;
       }
     }
 
@@ -527,7 +689,7 @@ class view {
        * like any other annotation, so it's easy to set at the top level view of
        * a data structure if all the values in the same share that attribute.
        */
-      if (!annotations_.type || !annotations_.endianness) {
+      if (!kind().type || !kind().endianness) {
         /* only check for the case that's explicitly disallowed, and allow
          * everything else. */
         return false;
@@ -556,8 +718,8 @@ class view {
   }
 
   constexpr bool checkValue(void) const {
-    if (annotations_.type) {
-      switch (*annotations_.type) {
+    if (const auto t = kind().type) {
+      switch (*t) {
         case dt_rom_bank:
           if (byte() >= banks()) {
             return false;
@@ -621,20 +783,323 @@ class view {
 };
 }  // namespace generic
 
-template <typename B = int8_t, typename W = int16_t>
-using view = generic::view<B, W, std::basic_string_view<B>>;
+template <typename B = int8_t, typename W = int16_t, typename K = B>
+using view = generic::view<B, W, std::basic_string_view<B>, K>;
 
 namespace container {
+/* fixed-stride table of things.
+ *
+ * @view the view type the table lives in.
+ * @thing the type of the table's records; needs to be constructible from a
+ * view, and to have a static constexpr stride, which is the size of each
+ * record in bytes.
+ *
+ * The table's extent is checked once, when it is constructed, so the accessors
+ * below don't need to check anything; a table that doesn't fit into the data
+ * it's a view of is cut short at the last complete record.
+ */
 template <typename view, typename thing>
 class array : view {
  public:
-  array(view v) : view(v) {}
+  using pointer = typename view::pointer;
+  using bytes = std::basic_string_view<
+      typename std::remove_cv<decltype(std::declval<view>().byte())>::type>;
+
+  static constexpr std::size_t stride = thing::stride;
+
+  array(view v) : array(v, v.size() / stride) {}
+
+  array(view v, const std::size_t count)
+      : view(v), count_{fit(v, count)} {}
+
+  std::size_t count(void) const { return count_; }
+
+  pointer at(const std::size_t i) const { return view::start_ + i * stride; }
+
+  /* the i-th record as a view; no bounds checking. */
+  thing operator[](const std::size_t i) const {
+    return thing{view::from(at(i)).to(at(i) + (stride - 1))};
+  }
+
+  /* the raw bytes of the i-th record; no bounds checking.
+   *
+   * This is the fast path for bulk decoding, as it skips constructing any
+   * views at all.
+   */
+  bytes raw(const std::size_t i) const {
+    return view::data_.substr(at(i).linear(), stride);
+  }
+
+  template <typename F>
+  void each(F f) const {
+    for (std::size_t i = 0; i < count_; i++) {
+      f(i, raw(i));
+    }
+  }
+
+ protected:
+  std::size_t count_;
+
+  static std::size_t fit(const view &v, const std::size_t count) {
+    const std::size_t start = v.startPtr().linear();
+    const std::size_t size = v.size() > 0 ? v.size() : 0;
+
+    if (start >= v.dataSize()) {
+      return 0;
+    }
+
+    return std::min(count, std::min(size, v.dataSize() - start) / stride);
+  }
 };
 
-template <typename view, typename thing>
+/* list of terminated, variable-length things.
+ *
+ * @view the view type the list lives in.
+ * @thing the type of the list's entries; needs to be constructible from a view,
+ * followed by @with, if there's anything in there.
+ * @with whatever else things need to be constructed, e.g. the language of a
+ * list of strings; this is passed to the constructor and kept.
+ *
+ * The list is scanned once, when it is constructed, to build an index of where
+ * each entry starts, so that any entry can then be looked up in constant time
+ * instead of walking the list from its start. Entries are only ever turned
+ * into things when they are accessed.
+ */
+template <typename view, typename thing, typename... with>
 class indirect : view {
  public:
-  indirect(view v) : view(v) {}
+  using pointer = typename view::pointer;
+  using byte = typename std::remove_cv<decltype(
+      std::declval<view>().byte())>::type;
+
+  /** @constructor
+   *
+   * @v a view starting at the first entry.
+   * @count the number of entries in the list.
+   * @terminator the byte that ends an entry.
+   * @length the size of each entry for lists with fixed-size entries, which
+   * are padded with @terminator; 0 for lists where each entry simply ends
+   * after its terminator.
+   *
+   * @w what's passed on to each thing's constructor.
+   *
+   * If the list runs past the end of @v, it is cut short after the last
+   * complete entry.
+   */
+  indirect(view v, const std::size_t count, const byte terminator,
+           const std::size_t length = 0, const with... w)
+      : view(v), index_{}, with_{w...} {
+    const auto data = view::data_;
+    const std::size_t end = std::min<std::size_t>(
+        data.size(), view::end_.linear() + 1);
+    std::size_t p = view::start_.linear();
+
+    index_.reserve(count + 1);
+
+    for (std::size_t i = 0; i < count && p < end; i++) {
+      std::size_t n = length;
+
+      if (length == 0) {
+        const auto t = data.find(terminator, p);
+        if (t == decltype(data)::npos || t >= end) {
+          break;
+        }
+        n = t - p + 1;
+      } else if (end - p < length) {
+        break;
+      }
+
+      index_.push_back(p);
+      p += n;
+    }
+
+    index_.push_back(p);
+  }
+
+  std::size_t count(void) const { return index_.size() - 1; }
+
+  pointer at(const std::size_t i) const { return pointer{index_[i]}; }
+
+  /* the i-th entry's bytes, including its terminator or padding. */
+  view raw(const std::size_t i) const {
+    return view::from(at(i)).to(pointer{index_[i + 1] - 1});
+  }
+
+  thing operator[](const std::size_t i) const {
+    return std::apply(
+        [this, i](const with &...w) { return thing{raw(i), w...}; }, with_);
+  }
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = thing;
+    using difference_type = std::ptrdiff_t;
+    using pointer = thing *;
+    using reference = thing &;
+
+    constexpr iterator(const indirect &list, const std::size_t i)
+        : list_(list), i_(i) {}
+
+    iterator &operator++(void) {
+      i_++;
+      return *this;
+    }
+    bool operator==(const iterator &b) const { return i_ == b.i_; }
+    bool operator!=(const iterator &b) const { return i_ != b.i_; }
+    thing operator*(void) const { return list_[i_]; }
+
+   protected:
+    const indirect &list_;
+    std::size_t i_;
+  };
+
+  iterator begin(void) const { return iterator{*this, 0}; }
+  iterator end(void) const { return iterator{*this, count()}; }
+
+ protected:
+  std::vector<std::size_t> index_;
+  std::tuple<with...> with_;
+};
+
+/* run of variable-length things, decoded on demand.
+ *
+ * @view the view type the run lives in.
+ * @thing the type of the run's entries; needs to be constructible from a view
+ * and to have a size(), in bytes, and should be false if it isn't valid.
+ *
+ * Things are only decoded while iterating, one at a time, and nothing is kept,
+ * so walking a sequence never allocates; count() and extent() walk it without
+ * keeping anything either. This suits records that can only be found by
+ * decoding everything in front of them, like evolution lists or trainer
+ * parties. Invalid things are skipped, while a thing with no size or one that
+ * doesn't fit into the view ends the run.
+ */
+template <typename view, typename thing>
+class sequence : view {
+ public:
+  using pointer = typename view::pointer;
+  using byte = typename std::remove_cv<decltype(
+      std::declval<view>().byte())>::type;
+
+  /* a sequence of @count things. */
+  static sequence counted(const view v, const std::size_t count) {
+    return sequence{v, count, {}};
+  }
+
+  /* a sequence that ends where the next thing would start with @terminator,
+   * and has at most @count things. */
+  static sequence terminated(const view v, const byte terminator,
+                             const std::size_t count = ~std::size_t(0)) {
+    return sequence{v, count, terminator};
+  }
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = thing;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const thing *;
+    using reference = const thing &;
+
+    iterator(const sequence &s, const typename sequence::pointer p,
+             const std::size_t left)
+        : sequence_(s), position_(p), left_(left) {
+      settle();
+    }
+
+    iterator &operator++(void) {
+      position_ += size_;
+      left_--;
+      settle();
+      return *this;
+    }
+
+    /* all iterators that are done compare equal, so end() doesn't need to
+     * know where the sequence ends. */
+    bool operator==(const iterator &b) const {
+      return done() == b.done() && (done() || position_ == b.position_);
+    }
+    bool operator!=(const iterator &b) const { return !(*this == b); }
+
+    const thing &operator*(void) const { return *current_; }
+    const thing *operator->(void) const { return &*current_; }
+
+    bool done(void) const { return !current_; }
+
+    /* where the current thing starts; once done, where the sequence ends,
+     * including the terminator if there was one. */
+    typename sequence::pointer position(void) const { return position_; }
+
+   protected:
+    const sequence &sequence_;
+    typename sequence::pointer position_;
+    std::size_t left_;
+    std::size_t size_{0};
+    std::optional<thing> current_{};
+
+    void settle(void) {
+      const auto &s = sequence_;
+      current_.reset();
+
+      while (left_ > 0 && s.within(position_, position_) &&
+             position_.linear() < s.dataSize()) {
+        if (s.terminator_ && s[position_] == *s.terminator_) {
+          position_ += 1;
+          break;
+        }
+
+        thing t{s.from(position_)};
+        const auto size = t.size();
+        const auto last = position_ + (size - 1);
+
+        if (size <= 0 || !s.within(last, last) ||
+            last.linear() >= s.dataSize()) {
+          break;
+        }
+
+        if (t) {
+          size_ = size;
+          current_.emplace(t);
+          return;
+        }
+
+        position_ += size;
+        left_--;
+      }
+
+      left_ = 0;
+    }
+  };
+
+  iterator begin(void) const { return iterator{*this, view::start_, count_}; }
+  iterator end(void) const { return iterator{*this, view::start_, 0}; }
+
+  /* the number of valid things in the sequence. */
+  std::size_t count(void) const {
+    std::size_t n = 0;
+    for (auto it = begin(); !it.done(); ++it) {
+      n++;
+    }
+    return n;
+  }
+
+  /* one past the end of the sequence, including its terminator. */
+  pointer extent(void) const {
+    auto it = begin();
+    while (!it.done()) {
+      ++it;
+    }
+    return it.position();
+  }
+
+ protected:
+  const std::size_t count_;
+  const std::optional<byte> terminator_;
+
+  sequence(const view v, const std::size_t count,
+           const std::optional<byte> terminator)
+      : view(v), count_{count}, terminator_{terminator} {}
 };
 }  // namespace container
 }  // namespace rom
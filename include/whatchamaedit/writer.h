@@ -0,0 +1,119 @@
+/* Typed writes
+ *
+ * Views only ever read; a writer pairs a view with the image it's over, so the
+ * same ranges and annotations that are used to read something can be used to
+ * change it:
+ *
+ *     writer{rom, header::format.at(view{rom}, header::f_globalChecksum)}
+ *         .word(0x1234);
+ *
+ * Everything is written at the start of the view, and is only written if all
+ * of it fits into the view; that is checked once per write, not per byte. The
+ * actual writing is done with the image's write(), so writes end up in the
+ * undo history and are passed on to anything that subscribed to the image.
+ */
+
+#if !defined(WHATCHAMAEDIT_WRITER_H)
+#define WHATCHAMAEDIT_WRITER_H
+
+#include <whatchamaedit/character-map.h>
+#include <whatchamaedit/image.h>
+
+#include <string>
+#include <string_view>
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class writer {
+ public:
+  using image = gameboy::rom::image<B, W, K>;
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  /** @constructor
+   *
+   * @rom the image to write to.
+   * @target where to write; needs to be a view over @rom.
+   */
+  writer(image &rom, const view &target) : rom_{rom}, target_{target} {}
+
+  const view &target(void) const { return target_; }
+
+  /* how many bytes can be written.
+   *
+   * This is the size of the view, or 0 if the view isn't over the image or
+   * reaches past its end.
+   */
+  std::size_t size(void) const {
+    const auto r = target_.raw();
+    const auto data = rom_.readonly();
+    const std::size_t start = target_.startPtr().linear();
+
+    if (start >= data.size() || r.data() != data.data() + start ||
+        ssize_t(r.size()) != target_.size()) {
+      return 0;
+    }
+
+    return r.size();
+  }
+
+  bool byte(const uint8_t b) {
+    const B d[1]{B(b)};
+    return range({d, 1});
+  }
+
+  /* write a word in the view's endianness; like reads, this defaults to
+   * little endian if the view doesn't say. */
+  bool word(const W w) {
+    const bool big = target_.expected().endianness == e_big_endian;
+    const B d[2]{B(big ? w >> 8 : w & 0xff), B(big ? w & 0xff : w >> 8)};
+    return range({d, 2});
+  }
+
+  bool range(const std::basic_string_view<B> d) {
+    if (d.size() > size()) {
+      return false;
+    }
+
+    return d.empty() || rom_.write(target_.startPtr(), d);
+  }
+
+  /* set every byte of the view to @b. */
+  bool fill(const B b) { return range(std::basic_string<B>(size(), b)); }
+
+  /* write text, padded with @terminator to the size of the view.
+   *
+   * Fails if @s can't be encoded or doesn't leave room for at least one
+   * terminator.
+   */
+  bool text(const std::string_view s, const ::text::encoder &encoder,
+            const B terminator) {
+    const auto encoded = encoder.encode(s);
+
+    if (!encoded || encoded->size() >= size()) {
+      return false;
+    }
+
+    std::basic_string<B> d(encoded->begin(), encoded->end());
+    d.resize(size(), terminator);
+
+    return range(d);
+  }
+
+  /* write text in @language, padded with its end byte; @encoder needs to be
+   * for the language's charmap, and is taken separately so it can be reused
+   * across writes. */
+  bool text(const std::string_view s, const ::text::encoder &encoder,
+            const ::text::language &language) {
+    return text(s, encoder, B(language.end()));
+  }
+
+ protected:
+  image &rom_;
+  const view target_;
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,210 @@
+/* Cross references
+ *
+ * An index of every place in a ROM that could be a pointer to some address,
+ * built in a single pass over the ROM, so that finding everything that
+ * references an address is a lookup rather than a search.
+ *
+ * The index is a compressed sparse row table keyed by linear target address:
+ * one offset per address in the ROM into a flat array of references. That's a
+ * perfect hash, so lookups are constant time and need no probing.
+ *
+ * Anything that looks like a pointer is indexed, so most references will be
+ * to data that happens to look like an address; it's up to the caller to
+ * decide which references are real, e.g. with the help of classify. Offsets
+ * below 0x100 are never indexed, since in practice those are almost always
+ * runs of zeroes rather than pointers to the restart vectors.
+ */
+
+#if !defined(WHATCHAMAEDIT_XREF_H)
+#define WHATCHAMAEDIT_XREF_H
+
+#include <whatchamaedit/view.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace gameboy {
+namespace rom {
+template <typename B = uint8_t, typename W = uint16_t, typename K = B>
+class xref {
+ public:
+  using view = gameboy::rom::view<B, W, K>;
+  using pointer = typename view::pointer;
+
+  enum kind : uint8_t {
+    /* a little endian offset that's resolved in the bank it's in, or a
+     * pointer into bank 0. */
+    near,
+    /* a bank number followed by a little endian offset, like lazy reads. */
+    bankFirst,
+    /* a little endian offset followed by a bank number. */
+    bankLast,
+    /* an offset into the switchable bank window, found in bank 0, so there's
+     * no telling which bank it's meant for. */
+    unbanked,
+  };
+
+  struct reference {
+    /* where the offset's low byte is. */
+    uint32_t at;
+    kind type;
+
+    /* where the bank number is, for far references. */
+    std::size_t bank(void) const {
+      return type == bankFirst ? at - 1 : type == bankLast ? at + 2 : at;
+    }
+  };
+
+  xref(const view &rom) {
+    const auto data = rom.raw();
+    const std::size_t bankSize = pointer::bankSize();
+    const std::size_t banks = data.size() / bankSize;
+
+    std::vector<std::pair<uint32_t, reference>> found{}, window{};
+    found.reserve(data.size() / 2);
+
+    candidates(data, [&](const std::size_t at) {
+      const std::size_t w = uint8_t(data[at]) | uint8_t(data[at + 1]) << 8;
+      const std::size_t bank = at / bankSize;
+
+      if (w < bankSize) {
+        found.push_back({uint32_t(w), {uint32_t(at), near}});
+        return;
+      }
+
+      const std::size_t offset = w - bankSize;
+
+      if (bank > 0) {
+        found.push_back(
+            {uint32_t(bank * bankSize + offset), {uint32_t(at), near}});
+      } else {
+        window.push_back({uint32_t(offset), {uint32_t(at), unbanked}});
+      }
+
+      if (at > 0) {
+        const std::size_t b = uint8_t(data[at - 1]);
+        if (b > 0 && b < banks) {
+          found.push_back(
+              {uint32_t(b * bankSize + offset), {uint32_t(at), bankFirst}});
+        }
+      }
+
+      if (at + 2 < data.size()) {
+        const std::size_t b = uint8_t(data[at + 2]);
+        if (b > 0 && b < banks) {
+          found.push_back(
+              {uint32_t(b * bankSize + offset), {uint32_t(at), bankLast}});
+        }
+      }
+    });
+
+    build(found, data.size(), offsets_, references_);
+    build(window, bankSize, unbankedOffsets_, unbankedReferences_);
+  }
+
+  /* all references to @target.
+   *
+   * References from bank 0 into the switchable bank window are included for
+   * every target in a switchable bank with a matching offset.
+   */
+  std::vector<reference> to(const pointer target) const {
+    const std::size_t t = target.linear();
+    const std::size_t bankSize = pointer::bankSize();
+    std::vector<reference> rv{};
+
+    if (t + 1 < offsets_.size()) {
+      rv.assign(references_.begin() + offsets_[t],
+                references_.begin() + offsets_[t + 1]);
+    }
+
+    if (t >= bankSize && t < offsets_.size()) {
+      const std::size_t o = t % bankSize;
+      rv.insert(rv.end(), unbankedReferences_.begin() + unbankedOffsets_[o],
+                unbankedReferences_.begin() + unbankedOffsets_[o + 1]);
+    }
+
+    return rv;
+  }
+
+  /* number of references to @target, not counting unbanked ones. */
+  std::size_t count(const pointer target) const {
+    const std::size_t t = target.linear();
+    return t + 1 < offsets_.size() ? offsets_[t + 1] - offsets_[t] : 0;
+  }
+
+  std::size_t size(void) const {
+    return references_.size() + unbankedReferences_.size();
+  }
+
+ protected:
+  std::vector<uint32_t> offsets_{};
+  std::vector<reference> references_{};
+  std::vector<uint32_t> unbankedOffsets_{};
+  std::vector<reference> unbankedReferences_{};
+
+  /* counting sort of (target, reference) pairs into an offset table with one
+   * more entry than there are @targets, and a flat array of references. */
+  static void build(const std::vector<std::pair<uint32_t, reference>> &found,
+                    const std::size_t targets, std::vector<uint32_t> &offsets,
+                    std::vector<reference> &references) {
+    offsets.assign(targets + 1, 0);
+
+    for (const auto &f : found) {
+      if (f.first < targets) {
+        offsets[f.first + 1]++;
+      }
+    }
+
+    for (std::size_t i = 1; i < offsets.size(); i++) {
+      offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    references.resize(offsets.back());
+
+    for (const auto &f : found) {
+      if (f.first < targets) {
+        references[next[f.first]++] = f.second;
+      }
+    }
+  }
+
+  /* call @f with every position in @data where a little endian word could be
+   * a pointer, i.e. where the high byte is between 0x01 and 0x7f. */
+  template <typename F>
+  static void candidates(const std::basic_string_view<B> data, F f) {
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 17 <= data.size(); i += 16) {
+      const __m128i high = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(data.data() + i + 1));
+
+      /* signed compare: 0x01 - 0x7f are positive, 0x80 - 0xff negative. */
+      for (unsigned m = _mm_movemask_epi8(_mm_cmpgt_epi8(high, zero)); m != 0;
+           m &= m - 1) {
+        f(i + __builtin_ctz(m));
+      }
+    }
+#endif
+
+    for (; i + 1 < data.size(); i++) {
+      const uint8_t high = data[i + 1];
+
+      if (0x01 <= high && high <= 0x7f) {
+        f(i);
+      }
+    }
+  }
+};
+}  // namespace rom
+}  // namespace gameboy
+
+#endif
@@ -0,0 +1,279 @@
+#include <ef.gy/cli.h>
+#include <whatchamaedit/align.h>
+#include <whatchamaedit/batch.h>
+#include <whatchamaedit/free-space.h>
+#include <whatchamaedit/rom.h>
+#include <whatchamaedit/signature.h>
+#include <whatchamaedit/sprite.h>
+#include <whatchamaedit/tiles.h>
+#include <whatchamaedit/xref.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static efgy::cli::flag<std::string> romFile("rom-file", "the ROM to load");
+
+static efgy::cli::flag<std::size_t> iterations(
+    "iterations", "how many times to run each benchmark; defaults to 10");
+
+/* run @f a number of times and print the average time it took. */
+template <typename F>
+static void measure(const std::string &name, F f) {
+  const std::size_t n = ::iterations > 0 ? std::size_t(::iterations) : 10;
+  const auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t i = 0; i < n; i++) {
+    f();
+  }
+
+  const std::chrono::duration<double, std::micro> t =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << name << "\t" << std::fixed << std::setprecision(1)
+            << t.count() / n << " us\n";
+}
+
+int main(int argc, char *argv[]) {
+  efgy::cli::options opts(argc, argv);
+
+  if (std::string{::romFile} == "") {
+    std::cerr << "no ROM file specified\n";
+    return 1;
+  }
+
+  whatchamaedit::rom::gb<> rom(romFile);
+
+  if (!rom) {
+    std::cerr << "NOT LOADED\n";
+    return 1;
+  }
+
+  {
+    /* views are copied by value everywhere, and these two make a lot of
+     * them, so they're mostly a measure of how large views are. */
+    using view = whatchamaedit::rom::gb<>::view;
+    using record = pokemon::bgry::baseStats<>;
+
+    std::cout << "sizeof(pointer)\t" << sizeof(view::pointer) << " bytes\n"
+              << "sizeof(view)\t" << sizeof(view) << " bytes\n"
+              << "sizeof(header)\t" << sizeof(rom.header) << " bytes\n";
+
+    const view v{rom};
+
+    /* so the compiler can't throw away all the work. */
+    volatile std::size_t sink = 0;
+
+    measure("header", [&v, &sink] {
+      const gameboy::rom::header<> h{v};
+      sink = h.title.size();
+    });
+
+    measure("header fields, constant offsets", [&v, &sink] {
+      using header = gameboy::rom::header<>;
+      const auto data = v.raw();
+
+      sink = header::format.byte(data, header::f_cartridge) +
+             header::format.byte(data, header::f_rom) +
+             header::format.byte(data, header::f_ram) +
+             header::format.word(data, header::f_globalChecksum);
+    });
+
+    measure("base stats records", [&v, &sink] {
+      const gameboy::rom::container::array<view, record> a{
+          v.from(pokemon::bgry::location::baseStats),
+          pokemon::bgry::location::baseStatsCount};
+      std::size_t n = 0;
+
+      for (std::size_t i = 0; i < a.count(); i++) {
+        for (const auto &f : a[i].fields()) {
+          n += bool(f);
+        }
+      }
+
+      sink = n;
+    });
+
+    measure("evolutions and learnsets", [&v, &sink] {
+      const pokemon::bgry::evosMoves<> em{v};
+      std::size_t n = 0;
+
+      for (std::size_t i = 0; i < em.count(); i++) {
+        n += em.evolutionsOf(i).count() + em.learnsetOf(i).count();
+      }
+
+      sink = n;
+    });
+  }
+
+  measure("sprites, 1 thread", [&rom] { pokemon::bgry::sprites s{rom, 1}; });
+  measure("sprites, all threads", [&rom] { pokemon::bgry::sprites s{rom}; });
+
+  measure("tiles, whole ROM", [&rom] {
+    const whatchamaedit::rom::gb<>::view v{rom};
+    graphics::tiles::banks(v);
+  });
+
+  measure("classify, 1 thread", [&rom] {
+    gameboy::rom::classify<> c{whatchamaedit::rom::gb<>::view{rom},
+                               rom.language(), 1};
+  });
+  measure("classify, all threads", [&rom] {
+    gameboy::rom::classify<> c{whatchamaedit::rom::gb<>::view{rom},
+                               rom.language()};
+  });
+
+  measure("cross references", [&rom] {
+    gameboy::rom::xref<> x{whatchamaedit::rom::gb<>::view{rom}};
+  });
+
+  measure("charmap detection", [&rom] {
+    whatchamaedit::rom::gb<>::detect d{whatchamaedit::rom::gb<>::view{rom}};
+  });
+
+  measure("strings, collected", [&rom] { rom.getStrings(); });
+  measure("strings, streamed", [&rom] {
+    std::size_t n = 0;
+    const auto count = [&n](const auto &s) { n += s.second.size(); };
+
+    rom.strings() | rom.decode() | gameboy::pipeline::each(count);
+  });
+
+  {
+    const auto strings = rom.getStrings();
+
+    measure("string lookups, all strings", [&strings] {
+      std::size_t n = 0;
+
+      for (const auto &s : strings) {
+        n += strings.at(s.first)->size();
+      }
+    });
+
+    measure("text index", [&strings] {
+      whatchamaedit::rom::gb<>::textIndex index{strings};
+    });
+
+    const whatchamaedit::rom::gb<>::textIndex index{strings};
+
+    measure("text search, one glyph", [&index] { index.find("é"); });
+    measure("text search, phrase", [&index] { index.find("POKé BALL"); });
+  }
+
+  {
+    /* a few hundred signatures taken from all over the ROM, with the second
+     * and third byte of each wildcarded like an address would be; padding
+     * is skipped, since signatures for that would match everywhere. */
+    const whatchamaedit::rom::gb<>::view v{rom};
+    const auto data = v.raw();
+    gameboy::rom::signatures<> sigs{};
+
+    for (std::size_t i = 0; sigs.size() < 300 && i < data.size(); i++) {
+      const std::size_t at = (i * 7919 * 64) % (data.size() - 12);
+      std::ostringstream os{};
+
+      if (std::count(&data[at], &data[at + 12], data[at]) > 4) {
+        continue;
+      }
+
+      for (std::size_t b = 0; b < 12; b++) {
+        if (b == 1 || b == 2) {
+          os << "?? ";
+        } else {
+          os << std::hex << std::setw(2) << std::setfill('0')
+             << unsigned(data[at + b]) << " ";
+        }
+      }
+
+      sigs.add(os.str(), os.str());
+    }
+
+    measure("300 signatures", [&sigs, &v] { sigs.find(v); });
+  }
+
+  {
+    /* align the ROM with a copy of itself that has some data inserted in the
+     * middle, which shifts everything after it. */
+    const whatchamaedit::rom::gb<>::view v{rom};
+    std::basic_string<uint8_t> copy{v.raw()};
+    copy.insert(copy.size() / 2, 0x1234, 0x42);
+    const whatchamaedit::rom::gb<>::view w{copy};
+
+    measure("alignment", [&v, &w] { gameboy::rom::alignment<> a{v, w}; });
+  }
+
+  {
+    /* wide bank numbers, on the ROM itself to compare with the above, and on
+     * an 8 MiB image made of copies of it, which is as large as MBC5 ROMs
+     * get. */
+    using wide = gameboy::rom::view<uint8_t, uint16_t, uint16_t>;
+    const auto data = whatchamaedit::rom::gb<>::view{rom}.raw();
+    std::basic_string<uint8_t> large{};
+
+    while (large.size() < 0x800000) {
+      large += data;
+    }
+    large.resize(0x800000);
+
+    const wide v{data}, w{large};
+
+    measure("cross references, wide", [&v] {
+      gameboy::rom::xref<uint8_t, uint16_t, uint16_t> x{v};
+    });
+    measure("cross references, 8 MiB", [&w] {
+      gameboy::rom::xref<uint8_t, uint16_t, uint16_t> x{w};
+    });
+    measure("classify, 8 MiB", [&w] {
+      gameboy::rom::classify<uint8_t, uint16_t, uint16_t> c{w};
+    });
+    measure("free space, 8 MiB", [&w] {
+      gameboy::rom::freespace<uint8_t, uint16_t, uint16_t> f{w};
+    });
+    measure("tiles, 8 MiB", [&w] { graphics::tiles::banks(w); });
+  }
+
+  {
+    /* these go last, as they change the ROM; the first one writes bank 1
+     * back onto itself, so at least its contents stay the same. */
+    using view = whatchamaedit::rom::gb<>::view;
+    const std::basic_string<uint8_t> bank{
+        view{rom}.from(0x4000).length(0x4000).raw()};
+
+    measure("write, one bank", [&rom, &bank] {
+      whatchamaedit::rom::gb<>::writer w{
+          rom, view{rom}.from(0x4000).length(0x4000)};
+      w.range(bank);
+    });
+
+    /* typing into a string: one byte changes, then all strings are listed
+     * again. */
+    const std::size_t at = rom.stringIndex()[rom.stringIndex().size() / 2]
+                               .first.linear();
+    uint8_t letter = 0x80;
+
+    measure("strings, after a one byte edit", [&rom, &at, &letter] {
+      letter = letter == 0x80 ? 0x81 : 0x80;
+      rom.write(at, {&letter, 1});
+      rom.stringIndex();
+    });
+
+    /* every string written back as it is, like importing a translation file
+     * that hasn't been translated yet. */
+    gameboy::rom::batch<> edits{};
+
+    for (const auto &s : rom.getStrings()) {
+      std::ostringstream os{};
+      os << "0x" << std::hex << s.first.linear();
+      edits.add(os.str(), std::string(s.second));
+    }
+
+    measure("batch, all strings, 1 thread",
+            [&rom, &edits] { edits.apply(rom, 1); });
+    measure("batch, all strings, all threads",
+            [&rom, &edits] { edits.apply(rom); });
+  }
+
+  return 0;
+}
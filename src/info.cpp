@@ -1,6 +1,21 @@
 #include <ef.gy/cli.h>
+#include <whatchamaedit/align.h>
+#include <whatchamaedit/batch.h>
+#include <whatchamaedit/cache.h>
 #include <whatchamaedit/debug.h>
+#include <whatchamaedit/discover.h>
+#include <whatchamaedit/free-space.h>
+#include <whatchamaedit/relocate.h>
 #include <whatchamaedit/rom.h>
+#include <whatchamaedit/signature.h>
+#include <whatchamaedit/sprite.h>
+#include <whatchamaedit/tiles.h>
+#include <whatchamaedit/translation.h>
+#include <whatchamaedit/xref.h>
+
+#include <iomanip>
+#include <iostream>
+#include <optional>
 
 static efgy::cli::flag<std::string> romFile("rom-file", "the ROM to load");
 
@@ -16,49 +31,623 @@ static efgy::cli::flag<bool> fixChecksum("fix-checksum",
 static efgy::cli::flag<bool> getStrings("strings",
                                         "like 'strings's for pokemon text");
 
-int main(int argc, char *argv[]) {
-  efgy::cli::options opts(argc, argv);
+static efgy::cli::flag<std::size_t> minLength(
+    "min-length", "with --strings, only show strings at least this long");
+
+static efgy::cli::flag<std::string> onlyBanks(
+    "bank",
+    "with --strings, only show strings in this bank, or in a range of banks "
+    "like 01-1f");
+
+static efgy::cli::flag<std::string> grepText(
+    "grep", "list strings that contain this text, like --strings does");
+
+static efgy::cli::flag<std::string> charmap(
+    "charmap",
+    "decode text as english, french, german, japanese or ascii, instead of "
+    "whichever one fits best");
+
+static efgy::cli::flag<bool> showCharmaps(
+    "charmaps", "show how well each known charmap fits the ROM's text");
+
+static efgy::cli::flag<bool> useCache(
+    "cache", "keep analysis results in a snapshot cache");
+
+static efgy::cli::flag<std::string> cacheDir(
+    "cache-dir", "where to keep snapshots; implies --cache");
+
+static efgy::cli::flag<std::string> applyEdits(
+    "apply-edits", "apply a batch of text edits from this file");
+
+static efgy::cli::flag<std::string> exportText(
+    "export-text",
+    "write all strings, with their addresses and how many bytes they may "
+    "take up, to this PO or CSV file for translation");
+
+static efgy::cli::flag<std::string> importText(
+    "import-text",
+    "apply the translations in this PO or CSV file, as written by "
+    "--export-text, as a single batch");
+
+static efgy::cli::flag<bool> showBaseStats(
+    "base-stats", "dump the Gen I base stats table");
+
+static efgy::cli::flag<bool> showNames(
+    "names", "list Gen I Pokemon, move and item names");
+
+static efgy::cli::flag<std::string> discoverText(
+    "discover-text",
+    "follow text scripts from these comma-separated entry points; use "
+    "address*count for text pointer tables");
+
+static efgy::cli::flag<std::string> exportSprites(
+    "export-sprites",
+    "write a sheet of all Gen I front and back sprites to this PNG or PGM "
+    "file");
+
+static efgy::cli::flag<std::string> exportTiles(
+    "export-tiles",
+    "render the ROM as 2bpp tiles to this PNG or PGM file, one sheet per "
+    "bank");
+
+static efgy::cli::flag<std::string> tileRange(
+    "tile-range",
+    "only render tiles from start-end, inclusive, with --export-tiles");
+
+static efgy::cli::flag<bool> showFreeSpace(
+    "free-space", "list runs of padding at the end of each bank");
+
+static efgy::cli::flag<bool> skipData(
+    "skip-data",
+    "with --strings, skip blocks that look like code, graphics or padding");
+
+static efgy::cli::flag<bool> showRegions(
+    "regions", "show what each 256 byte block of the ROM appears to be");
+
+static efgy::cli::flag<std::string> regionMap(
+    "region-map", "write a heatmap of --regions to this PPM file");
+
+static efgy::cli::flag<std::string> showReferences(
+    "xref", "list everything that could be a pointer to these comma-separated "
+            "addresses");
+
+static efgy::cli::flag<std::string> relocateBlock(
+    "relocate",
+    "move start-end to destination and update all references to it; use "
+    "'start-end,destination', or 'start-end,auto' to use free space");
 
-  if (std::string{::romFile} != "") {
-    whatchamaedit::rom::gb<> rom(romFile);
+static efgy::cli::flag<bool> dryRun(
+    "dry-run", "with --relocate, only show what would be changed");
 
-    if (rom) {
-      if (::showHeader) {
-        std::cout << debug::dump(rom.header) << "\n";
+static efgy::cli::flag<std::string> findSignatures(
+    "find-sig", "find the byte signatures in this file");
+
+static efgy::cli::flag<std::string> alignWith(
+    "align-with", "map addresses in the ROM to addresses in this ROM");
+
+static efgy::cli::flag<std::string> translateAddresses(
+    "translate",
+    "with --align-with, the comma-separated addresses to map; lists all "
+    "common segments if not given");
+
+/* the banks in @spec, which is a hex bank number or a range of them like
+ * 01-1f; all of them if @spec is empty. */
+static std::optional<std::pair<std::size_t, std::size_t>> bankRange(
+    const std::string &spec) {
+  if (spec.empty()) {
+    return std::make_pair(std::size_t(0), ~std::size_t(0));
+  }
+
+  const auto number = [](const std::string &n) -> std::optional<std::size_t> {
+    char *end = nullptr;
+    const std::size_t v = std::strtoul(n.c_str(), &end, 16);
+
+    if (n.empty() || *end != 0) {
+      return {};
+    }
+
+    return v;
+  };
+
+  const auto dash = spec.find('-');
+  const auto first = number(spec.substr(0, dash));
+  const auto last =
+      dash == std::string::npos ? first : number(spec.substr(dash + 1));
+
+  if (!first || !last || *last < *first) {
+    return {};
+  }
+
+  return std::make_pair(*first, *last);
+}
+
+/* everything the tool does with a ROM.
+ *
+ * @K the type of a bank number in the ROM; see whatchamaedit::rom::gb.
+ */
+template <typename K = uint8_t>
+static int run(void) {
+  using gb = whatchamaedit::rom::gb<K>;
+  using pointer = typename gb::pointer;
+  using view = typename gb::view;
+
+  gb rom(romFile);
+
+  if (rom) {
+    if (::showHeader) {
+      std::cout << debug::dump(rom.header) << "\n";
+    } else {
+      std::cout << rom.title() << "\n";
+    }
+
+    if (const std::string name = charmap; !name.empty()) {
+      if (const auto *l = text::languages::byName(name)) {
+        rom.language(*l);
       } else {
-        std::cout << rom.title() << "\n";
+        std::cerr << "unknown charmap: " << name << "\n";
+      }
+    }
+
+    if (::showCharmaps) {
+      const typename gb::detect d{view{rom}};
+
+      for (const auto &s : d.scores()) {
+        std::cout << s.language->name() << "\t" << std::dec << s.text
+                  << " letters\t" << s.words << " words\n";
       }
 
-      if (::getStrings) {
-        const auto strs = rom.getStrings();
+      std::cout << "using " << rom.language().name() << "\n";
+    }
 
-        for (const auto &str : strs) {
+    const bool cached = ::useCache || !std::string(cacheDir).empty();
+
+    if (const std::string query = grepText; ::getStrings || !query.empty()) {
+      using namespace gameboy::pipeline;
+
+      const auto banks = bankRange(onlyBanks);
+      const std::size_t length = minLength;
+
+      /* strings are printed as they're found, rather than after the whole ROM
+       * has been scanned. */
+      const auto print = each([](const auto &s) {
+        std::cout << "0x" << std::hex << std::setw(6) << std::setfill('0')
+                  << s.first.linear() << " " << s.second << "\n";
+      });
+      const auto inBanks = [&banks](const pointer p) {
+        return banks->first <= p.bank() && p.bank() <= banks->second;
+      };
+      /* the snapshot and the search index have all strings, so --skip-data
+       * needs to be applied to those separately. */
+      const auto wanted = [&rom, &inBanks](const pointer p) {
+        return inBanks(p) && !(::skipData && rom.inData(p));
+      };
+      const auto longEnough = filter(
+          [length](const auto &s) { return s.second.size() >= length; });
+
+      /* a snapshot that can't be used is no reason not to list strings, so
+       * those come from the ROM itself instead. */
+      std::optional<whatchamaedit::cache::snapshot> snap{};
+
+      if (cached && banks) {
+        const std::string dir = std::string(cacheDir).empty()
+                                    ? whatchamaedit::cache::directory()
+                                    : std::string(cacheDir);
+        snap.emplace(whatchamaedit::cache::snapshot::open(dir, rom));
+
+        if (!*snap) {
+          std::cerr << "could not use snapshot cache in " << dir << "\n";
+          snap.reset();
+        }
+      }
+
+      if (!banks) {
+        std::cerr << "not a bank or range of banks: "
+                  << std::string(onlyBanks) << "\n";
+      } else if (snap) {
+        const auto strings = from(snap->strings()) |
+                             transform([&snap](const auto &s) {
+                               return std::make_pair(pointer{s.pointer},
+                                                     snap->text(s));
+                             }) |
+                             filter([&wanted](const auto &s) {
+                               return wanted(s.first);
+                             });
+
+        if (query.empty()) {
+          strings | longEnough | print;
+        } else {
+          /* the snapshot already has the decoded text, so searching it
+           * doesn't need a scan of the ROM. */
+          typename gb::stringTable table{rom.language()};
+          const auto add = [&table](const auto &s) {
+            table.add(s.first, s.second);
+          };
+
+          strings | each(add);
+
+          from(typename gb::textIndex{table}.find(query)) | longEnough | print;
+        }
+      } else if (!query.empty()) {
+        from(rom.grep(query)) |
+            filter([&wanted](const auto &s) { return wanted(s.first); }) |
+            longEnough | print;
+      } else {
+        rom.strings(::skipData) | filter(inBanks) | rom.decode() |
+            longEnough | print;
+      }
+    }
+
+    if (::showBaseStats) {
+      const auto &stats = rom.tables().stats;
+
+      if (stats.size() == 0) {
+        std::cerr << "no Gen I base stats where Red and Blue have them\n";
+      }
+
+      std::cout << "dex\thp\tatk\tdef\tspd\tspc\n" << std::dec;
+      for (std::size_t i = 0; i < stats.size(); i++) {
+        std::cout << int(stats.dex[i]) << "\t" << int(stats.hp[i]) << "\t"
+                  << int(stats.attack[i]) << "\t" << int(stats.defense[i])
+                  << "\t" << int(stats.speed[i]) << "\t"
+                  << int(stats.special[i]) << "\n";
+      }
+    }
+
+    if (::showNames) {
+      const auto list = [](std::string_view kind, const auto &names) {
+        std::size_t i = 1;
+
+        if (names.count() == 0) {
+          std::cerr << "no Gen I " << kind
+                    << " names where Red and Blue have them\n";
+        }
+
+        for (const auto &name : names) {
+          std::cout << kind << " " << std::dec << i++ << " "
+                    << name.translated() << "\n";
+        }
+      };
+
+      list("monster", rom.names().monsters);
+      list("move", rom.names().moves);
+      list("item", rom.names().items);
+    }
+
+    if (const std::string file = regionMap; ::showRegions || !file.empty()) {
+      const auto &regions = rom.regions();
+
+      if (::showRegions) {
+        std::cout << regions.map();
+
+        for (const auto r : {gameboy::r_code, gameboy::r_text,
+                             gameboy::r_graphics, gameboy::r_pointers,
+                             gameboy::r_padding, gameboy::r_unknown}) {
+          std::cout << regions.symbol(r) << " " << regions.name(r) << ": "
+                    << std::dec << regions.count(r) << " blocks\n";
+        }
+      }
+
+      if (!file.empty()) {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+
+        if (!regions.ppm(out)) {
+          std::cerr << file << ": could not write heatmap\n";
+        }
+      }
+    }
+
+    if (const std::string file = alignWith; !file.empty()) {
+      const gb other(file);
+
+      if (!other) {
+        std::cerr << file << ": could not load ROM\n";
+      } else {
+        const gameboy::rom::alignment<uint8_t, uint16_t, K> map{view{rom},
+                                                                view{other}};
+        const std::string addresses = translateAddresses;
+        std::istringstream in(addresses);
+
+        for (std::string address; std::getline(in, address, ',');) {
+          const auto p = pointer::parse(address);
+          const auto q = p ? map.translate(*p) : std::optional<pointer>{};
+
+          std::cout << address << " -> ";
+          if (q) {
+            std::cout << "0x" << std::hex << std::setw(6)
+                      << std::setfill('0') << q->linear() << "\n";
+          } else {
+            std::cout << "?\n";
+          }
+        }
+
+        if (addresses.empty()) {
+          for (const auto &s : map.segments()) {
+            std::cout << "0x" << std::hex << std::setw(6)
+                      << std::setfill('0') << s.a << " -> 0x" << std::setw(6)
+                      << s.b << " " << std::dec << s.length << "\n";
+          }
+        }
+
+        std::cout << std::dec << map.coverage() * 100 << "% mapped\n";
+      }
+    }
+
+    if (const std::string file = findSignatures; !file.empty()) {
+      gameboy::rom::signatures<uint8_t, uint16_t, K> sigs{};
+      std::ifstream in(file);
+
+      if (!in) {
+        std::cerr << file << ": could not open signature file\n";
+      } else if (!sigs.load(in)) {
+        for (const auto &e : sigs.errors()) {
+          std::cerr << file << ":" << std::dec << e.line << ": "
+                    << e.message << "\n";
+        }
+      }
+
+      for (const auto &h : sigs.find(view{rom})) {
+        std::cout << sigs.all()[h.signature].name << " 0x" << std::hex
+                  << std::setw(6) << std::setfill('0') << h.at.linear()
+                  << "\n";
+      }
+    }
+
+    if (const std::string targets = showReferences; !targets.empty()) {
+      using xref = gameboy::rom::xref<uint8_t, uint16_t, K>;
+      static const char *kinds[]{"near", "bank first", "bank last",
+                                 "unbanked"};
+
+      const xref index{view{rom}};
+      std::istringstream in(targets);
+
+      for (std::string target; std::getline(in, target, ',');) {
+        const auto p = pointer::parse(target);
+
+        if (!p) {
+          std::cerr << "not an address: " << target << "\n";
+          continue;
+        }
+
+        for (const auto &r : index.to(*p)) {
           std::cout << "0x" << std::hex << std::setw(6) << std::setfill('0')
-                    << str.first.linear() << " " << str.second << "\n";
+                    << p->linear() << " <- 0x" << std::setw(6) << r.at << " "
+                    << kinds[r.type] << "\n";
         }
       }
+    }
+
+    if (::showFreeSpace) {
+      const gameboy::rom::freespace<uint8_t, uint16_t, K> space{view{rom}};
 
-      if (::fixChecksum) {
-        rom.fixChecksum();
+      for (const auto &[start, end] : space.free()) {
+        std::cout << "0x" << std::hex << std::setw(6) << std::setfill('0')
+                  << start << "-0x" << std::setw(6) << end - 1 << " "
+                  << std::dec << end - start << "\n";
       }
 
-      if (!std::string(output).empty()) {
-        rom.save(output);
+      std::cout << std::dec << space.available() << " bytes free\n";
+    }
+
+    if (const std::string seeds = discoverText; !seeds.empty()) {
+      gameboy::rom::discover<uint8_t, uint16_t, K> texts{rom};
+      std::istringstream in(seeds);
+
+      for (std::string seed; std::getline(in, seed, ',');) {
+        const auto star = seed.find('*');
+        const auto p = pointer::parse(seed.substr(0, star));
+        std::size_t count = 0;
+
+        if (star != std::string::npos) {
+          count = std::strtoul(seed.c_str() + star + 1, nullptr, 0);
+        }
+
+        if (!p) {
+          std::cerr << "not an address: " << seed << "\n";
+        } else if (star == std::string::npos) {
+          texts.entry(*p);
+        } else {
+          texts.table(*p, count);
+        }
       }
-    } else {
-      std::cerr << "NOT LOADED\n";
 
-      if (rom.checksum()) {
-        std::cout << "CHECKSUM OK\n";
+      texts.run();
+
+      for (const auto &e : texts.extents()) {
+        std::cout << "0x" << std::hex << std::setw(6) << std::setfill('0')
+                  << e.start.linear() << "-0x" << std::setw(6)
+                  << e.end.linear() << " "
+                  << rom.getString(e.start.linear(), e.end.linear())
+                  << "\n";
+      }
+    }
+
+    if (const std::string file = exportSprites; !file.empty()) {
+      const pokemon::bgry::sprites sprites{rom};
+      std::size_t failed = 0;
+
+      if (sprites.front.empty()) {
+        std::cerr << "no Gen I base stats, so no sprites to export\n";
+      }
+
+      for (const auto *s : {&sprites.front, &sprites.back}) {
+        failed += std::count(s->begin(), s->end(), std::nullopt);
+      }
+
+      if (failed > 0) {
+        std::cerr << std::dec << failed << " sprites could not be decoded\n";
+      }
+
+      if (!sprites.sheet().save(file)) {
+        std::cerr << file << ": could not write sprite sheet\n";
+      }
+    }
+
+    if (const std::string file = exportTiles; !file.empty()) {
+      const std::string range = tileRange;
+      const view v{rom};
+      graphics::bitmap sheet{};
+
+      if (range.empty()) {
+        sheet = graphics::tiles::banks(v);
+      } else {
+        const auto dash = range.find('-');
+        const auto start = pointer::parse(range.substr(0, dash));
+        const auto end = dash == std::string::npos
+                             ? std::optional<pointer>{}
+                             : pointer::parse(range.substr(dash + 1));
+
+        if (!start || !end || *end < *start) {
+          std::cerr << "not a range: " << range << "\n";
+        } else {
+          sheet = graphics::tiles::sheet(v.from(*start).to(*end).asTiles());
+        }
+      }
+
+      if (sheet.width() > 0 && !sheet.save(file)) {
+        std::cerr << file << ": could not write tile sheet\n";
+      }
+    }
+
+    if (const std::string file = applyEdits; !file.empty()) {
+      gameboy::rom::batch<uint8_t, uint16_t, K> edits{};
+      std::ifstream in(file);
+
+      if (!in) {
+        std::cerr << file << ": could not open batch file\n";
+      } else if (!edits.load(in) || !edits.apply(rom)) {
+        for (const auto &e : edits.errors()) {
+          std::cerr << file << ":" << std::dec << e.line << ": "
+                    << e.message << "\n";
+        }
+        std::cerr << "batch not applied\n";
+      } else {
+        std::cout << std::dec << edits.applied() << " edits applied\n";
+      }
+    }
+
+    if (const std::string file = exportText; !file.empty()) {
+      using translations = gameboy::rom::translations<uint8_t, uint16_t, K>;
+      const auto format = translations::formatOf(file);
+      std::ofstream out(file, std::ios::binary | std::ios::trunc);
+
+      if (!format) {
+        std::cerr << file << ": not a .po or .csv file\n";
+      } else if (!out) {
+        std::cerr << file << ": could not open for writing\n";
+      } else {
+        translations::save(out, *format, view{rom}, rom.stringIndex());
+      }
+    }
+
+    if (const std::string file = importText; !file.empty()) {
+      using translations = gameboy::rom::translations<uint8_t, uint16_t, K>;
+      const auto format = translations::formatOf(file);
+      std::ifstream in(file, std::ios::binary);
+      translations t{};
+      gameboy::rom::batch<uint8_t, uint16_t, K> edits{};
+
+      if (!format) {
+        std::cerr << file << ": not a .po or .csv file\n";
+      } else if (!in) {
+        std::cerr << file << ": could not open translation file\n";
+      } else if (!t.load(in, *format, edits) || !edits.apply(rom)) {
+        for (const auto &e : t.errors()) {
+          std::cerr << file << ":" << std::dec << e.line << ": "
+                    << e.message << "\n";
+        }
+        for (const auto &e : edits.errors()) {
+          std::cerr << file << ":" << std::dec << e.line << ": "
+                    << e.message << "\n";
+        }
+        std::cerr << "translations not applied\n";
       } else {
-        std::cout << "CHECKSUM NOT OK (" << rom.romChecksum() << " vs "
-                  << rom.headerChecksum() << ")\n";
+        std::cout << std::dec << edits.applied() << " translations applied\n";
       }
     }
+
+    if (const std::string spec = relocateBlock; !spec.empty()) {
+      using xref = gameboy::rom::xref<uint8_t, uint16_t, K>;
+
+      const auto dash = spec.find('-');
+      const auto comma = spec.find(',', dash);
+      const auto start = pointer::parse(spec.substr(0, dash));
+      const auto end = dash == std::string::npos
+                           ? std::optional<pointer>{}
+                           : pointer::parse(spec.substr(dash + 1,
+                                                        comma - dash - 1));
+      const std::string to =
+          comma == std::string::npos ? "" : spec.substr(comma + 1);
+      std::optional<pointer> destination{};
+
+      if (start && end && *start <= *end) {
+        const std::size_t size = end->linear() - start->linear() + 1;
+
+        if (to == "auto") {
+          gameboy::rom::freespace<uint8_t, uint16_t, K> space{view{rom}};
+          destination = space.allocate(size, start->bank());
+          if (!destination) {
+            destination = space.allocate(size);
+          }
+        } else {
+          destination = pointer::parse(to);
+        }
+      }
+
+      if (!start || !end || *end < *start || !destination) {
+        std::cerr << "can't relocate " << spec << "\n";
+      } else {
+        const view v{rom};
+        const xref index{v};
+        const auto &regions = rom.regions();
+
+        /* references from graphics are almost certainly just bytes that
+         * happen to look like an address. */
+        const gameboy::rom::relocation<uint8_t, uint16_t, K> move{
+            v, index, v.from(*start).to(*end), *destination,
+            [&regions](const typename xref::reference &r) {
+              return regions.at(pointer{std::size_t(r.at)}) !=
+                     gameboy::r_graphics;
+            }};
+
+        move.report(std::cout);
+
+        if (!::dryRun && !move.apply(rom)) {
+          std::cerr << "relocation not applied\n";
+        }
+      }
+    }
+
+    if (::fixChecksum) {
+      rom.fixChecksum();
+    }
+
+    if (!std::string(output).empty()) {
+      rom.save(output);
+    }
   } else {
     std::cerr << "NOT LOADED\n";
-    std::cout << "no ROM file specified\n";
+
+    if (rom.checksum()) {
+      std::cout << "CHECKSUM OK\n";
+    } else {
+      std::cout << "CHECKSUM NOT OK (" << rom.romChecksum() << " vs "
+                << rom.headerChecksum() << ")\n";
+    }
   }
 
   return 0;
 }
+
+int main(int argc, char *argv[]) {
+  efgy::cli::options opts(argc, argv);
+
+  if (std::string{::romFile} == "") {
+    std::cerr << "NOT LOADED\n";
+    std::cout << "no ROM file specified\n";
+    return 0;
+  }
+
+  /* ROMs with more than 256 banks need wider bank numbers; everything else
+   * sticks with bytes. */
+  return whatchamaedit::rom::gb<>::wide(romFile) ? run<uint16_t>() : run<>();
+}